@@ -24,6 +24,7 @@
 #include <QMessageBox>
 #include <QPrintDialog>
 #include <QPrinter>
+#include <QProgressDialog>
 #include <QRegExp>
 #include <QScrollArea>
 #include <QScrollBar>
@@ -65,6 +66,7 @@ struct MainWindowImpl::Impl
     QBoardHomeView * tree;
     PieceAppearanceWidget *paw;
     QWidget * sidebar;
+    QProgressDialog * progress;
     static char const * pieceTemplatesFile;
     static char const * geometryFile;
     static char const * persistanceClass;
@@ -74,7 +76,8 @@ struct MainWindowImpl::Impl
 	gv(0),
 	tree(0),
 	paw(new PieceAppearanceWidget),
-	sidebar(0)
+	sidebar(0),
+	progress(0)
     {
 	QDir pdir = qboard::persistenceDir( persistanceClass );
 	try
@@ -130,6 +133,12 @@ MainWindowImpl::MainWindowImpl( QWidget * parent, Qt::WFlags f)
 	connect( this->actionClearBoard, SIGNAL(triggered(bool)), this, SLOT(clearBoard()) );
 	connect( this->actionQuickSave, SIGNAL(triggered(bool)), this, SLOT(quickSave()) );
 	connect( this->actionQuickLoad, SIGNAL(triggered(bool)), this, SLOT(quickLoad()) );
+	connect( &impl->gstate, SIGNAL(loadFinished(QString const &,bool)),
+		 this, SLOT(gameLoaded(QString const &,bool)) );
+	connect( &impl->gstate, SIGNAL(saveFinished(QString const &,bool)),
+		 this, SLOT(gameSaved(QString const &,bool)) );
+	connect( &impl->gstate, SIGNAL(ioProgress(int,int)),
+		 this, SLOT(updateIOProgress(int,int)) );
 
 
 	impl->gstate.enablePlacemarker(true);
@@ -294,35 +303,71 @@ void MainWindowImpl::launchHelp()
 			      QMessageBox::Ok, QMessageBox::Ok );
 #endif
 }
-bool MainWindowImpl::saveGame( QString const & fn )
+void MainWindowImpl::showIOProgress( QString const & label )
 {
-    bool b = false;
-    std::ostringstream os;
-    try
+    if( ! impl->progress )
     {
-	b = impl->gstate.s11nSave( fn, true );
-	os << "failed for unknown reason.";
+	impl->progress = new QProgressDialog( this );
+	impl->progress->setWindowModality( Qt::WindowModal );
+	impl->progress->setMinimumDuration( 500 );
+	impl->progress->setAutoClose( false );
+	impl->progress->setAutoReset( false );
+	connect( impl->progress, SIGNAL(canceled()), &impl->gstate, SLOT(cancelIO()) );
     }
-    catch( std::exception const & ex )
+    impl->progress->setLabelText( label );
+    impl->progress->setRange( 0, 0 );
+    impl->progress->setValue( 0 );
+}
+
+void MainWindowImpl::hideIOProgress()
+{
+    if( ! impl->progress ) return;
+    impl->progress->reset(); // also stops its delayed-show timer
+    impl->progress->hide();
+}
+
+void MainWindowImpl::updateIOProgress( int done, int total )
+{
+    if( ! impl->progress ) return;
+    if( impl->progress->maximum() != total )
+    {
+	impl->progress->setRange( 0, total );
+    }
+    impl->progress->setValue( done );
+}
+
+bool MainWindowImpl::saveGame( QString const & fn )
+{
+    if( ! impl->gstate.saveAsync( fn, true ) )
     {
-	b = false;
-	os << "Save failed! The error text is:\n"
-	   << ex.what();
+	QString msg( impl->gstate.isBusy()
+		     ? QString("Another load or save is still running.")
+		     : impl->gstate.ioErrorString() );
+	this->statusBar()->showMessage("Save FAILED: "+fn);
+	QMessageBox::warning( this, "Save failed!",
+			      "Save failed! The error text is:\n" + msg,
+			      QMessageBox::Ok, QMessageBox::Ok );
+	return false;
     }
+    this->showIOProgress( "Saving "+fn );
+    return true;
+}
 
-    if( b )
+void MainWindowImpl::gameSaved( QString const & fn, bool ok )
+{
+    this->hideIOProgress();
+    if( ok )
     {
-	    this->statusBar()->showMessage("Saved: "+fn);
+	this->statusBar()->showMessage("Saved: "+fn);
     }
     else
     {
 	this->statusBar()->showMessage("Save FAILED: "+fn);
-	QMessageBox::warning( this, "Save failed!", os.str().c_str(),
+	QMessageBox::warning( this, "Save failed!",
+			      "Save failed! The error text is:\n" + impl->gstate.ioErrorString(),
 			      QMessageBox::Ok, QMessageBox::Ok );
     }
     this->actionRefreshFileList->activate( QAction::Trigger );
-    return b;
-	
 }
 bool MainWindowImpl::saveGame()
 {
@@ -361,7 +406,8 @@ bool MainWindowImpl::loadFile( QFileInfo const & fi )
 	}
 	else if( impl->gstate.fileNameMatches(fn) )
 	{
-		worked = this->loadGame(fn);
+		// Reports its own results via gameLoaded().
+		return this->loadGame(fn);
 	}
 	else if( fn.endsWith(".wiki") )
 	{
@@ -476,17 +522,27 @@ bool MainWindowImpl::loadPiece( QFileInfo const & fi )
 
 bool MainWindowImpl::loadGame( QString const & fn )
 {
-	QApplication::setOverrideCursor(Qt::BusyCursor);
-	bool b = impl->gstate.s11nLoad(fn); 
-	QApplication::restoreOverrideCursor();
-	if( ! b )
+	if( ! impl->gstate.loadAsync(fn) )
 	{
-		this->statusBar()->showMessage("Load FAILED: "+fn);
+		this->statusBar()->showMessage("Load FAILED (another load or save is still running): "+fn);
 		return false;
 	}
-	this->statusBar()->showMessage("Loaded board: "+fn);
+	this->showIOProgress( "Loading "+fn );
 	return true;
 }
+
+void MainWindowImpl::gameLoaded( QString const & fn, bool ok )
+{
+	this->hideIOProgress();
+	if( ! ok )
+	{
+		QString err( impl->gstate.ioErrorString() );
+		this->statusBar()->showMessage("Load FAILED: "+fn
+					       +(err.isEmpty() ? QString() : (" ("+err+")")));
+		return;
+	}
+	this->statusBar()->showMessage("Loaded board: "+fn);
+}
 bool MainWindowImpl::loadGame()
 {
 	QString fn = QFileDialog::getOpenFileName(this,
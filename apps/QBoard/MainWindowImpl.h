@@ -53,6 +53,13 @@ private Q_SLOTS:
 	void chdir(const QDir & dir);
     void clipboardUpdated();
     void clearClipboard();
+    void gameLoaded( QString const & fn, bool ok );
+    void gameSaved( QString const & fn, bool ok );
+    void updateIOProgress( int done, int total );
+private:
+    /** Shows the load/save progress dialog with the given label. */
+    void showIOProgress( QString const & label );
+    void hideIOProgress();
 private:
 	struct Impl;
 	Impl * impl;
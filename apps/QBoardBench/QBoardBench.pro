@@ -0,0 +1,11 @@
+include(../../config.qmake)
+TEMPLATE = app
+win32:CONFIG += console
+mac:CONFIG -= app_bundle
+QT += script svg
+QMAKE_CXXFLAGS = $$QBOARD_CXXFLAGS
+
+SOURCES = \
+ main.cpp
+
+LIBS += -L$$DESTDIR -lQBoard -lQBoardS11n
@@ -0,0 +1,158 @@
+/************************************************************************
+QBoardBench: timing harness for QBoard's performance-sensitive bits.
+
+Usage: QBoardBench [benchmark names...]
+
+With no arguments all benchmarks are run. Results go to stdout as
+plain-text tables.
+************************************************************************/
+#include <QApplication>
+#include <QGraphicsRectItem>
+#include <QStringList>
+#include <QTime>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <stdexcept>
+
+#include <qboard/QBoardScene.h>
+#include <s11n.net/s11n/variant.hpp>
+
+/**
+   Fills sc with count 50x50 items scattered over a board big enough
+   that the items overlap roughly as densely as counters on a real
+   campaign map.
+*/
+static QSizeF populateScene( QGraphicsScene & sc, int count )
+{
+    const qreal side = 50;
+    const qreal edge = side * 4 * std::sqrt( qreal(count) ) + side;
+    std::srand( 42 ); // same layout for every mode
+    for( int i = 0; i < count; ++i )
+    {
+	QGraphicsRectItem * it = new QGraphicsRectItem( 0, 0, side, side );
+	it->setPos( (std::rand() % int(edge)), (std::rand() % int(edge)) );
+	it->setFlag( QGraphicsItem::ItemIsSelectable, true );
+	it->setFlag( QGraphicsItem::ItemIsMovable, true );
+	sc.addItem( it );
+    }
+    return QSizeF( edge, edge );
+}
+
+/**
+   Measures the average latency (in microseconds) of itemAt()-style
+   hit tests and collidingItems() against the item count, for each
+   QBoardScene index mode.
+*/
+static void benchSceneIndex()
+{
+    const int counts[] = { 100, 1000, 5000, 10000, 0 };
+    const int probes = 2000;
+    QBoardScene::IndexMode const modes[] = { QBoardScene::IndexNone, QBoardScene::IndexBsp };
+    std::cout << "Scene hit-test latency (usec per call, " << probes << " calls per cell):\n"
+	      << std::setw(8) << "items"
+	      << std::setw(12) << "mode"
+	      << std::setw(12) << "items(pt)"
+	      << std::setw(12) << "colliding"
+	      << '\n';
+    for( int c = 0; counts[c]; ++c )
+    {
+	for( int m = 0; m < 2; ++m )
+	{
+	    QBoardScene sc;
+	    sc.setIndexMode( modes[m] );
+	    const QSizeF board( populateScene( sc, counts[c] ) );
+	    QList<QGraphicsItem*> all( sc.items() );
+	    sc.items( QPointF(0,0) ); // let BSP build its tree before timing
+	    std::srand( 7 );
+	    QTime timer;
+	    timer.start();
+	    int hits = 0;
+	    for( int i = 0; i < probes; ++i )
+	    {
+		QPointF pt( std::rand() % int(board.width()), std::rand() % int(board.height()) );
+		hits += sc.items( pt ).size();
+	    }
+	    const double tHit = timer.elapsed() * 1000.0 / probes;
+	    timer.restart();
+	    for( int i = 0; i < probes; ++i )
+	    {
+		hits += all.at( i % all.size() )->collidingItems().size();
+	    }
+	    const double tColl = timer.elapsed() * 1000.0 / probes;
+	    std::cout << std::setw(8) << counts[c]
+		      << std::setw(12) << QBoardScene::indexModeToString(modes[m]).toAscii().constData()
+		      << std::setw(12) << std::fixed << std::setprecision(2) << tHit
+		      << std::setw(12) << tColl
+		      << "   (" << hits << " hits)\n";
+	}
+    }
+}
+
+/**
+   Times a round trip of count values of type T through text, once
+   with the stream-based lexical casting and once with variant's
+   specialized path (ms).
+*/
+template <typename T>
+static void timeLexicalCast( char const * label, int count, T (*make)(int) )
+{
+    using namespace s11n::Detail::Private;
+    std::size_t sink = 0;
+    QTime timer;
+    timer.start();
+    for( int i = 0; i < count; ++i )
+    {
+	sink += stream_from_string( stream_to_string( make(i) ), T() ) != T();
+    }
+    const int tStream = timer.elapsed();
+    timer.restart();
+    for( int i = 0; i < count; ++i )
+    {
+	sink += from_string( to_string( make(i) ), T() ) != T();
+    }
+    const int tFast = timer.elapsed();
+    std::cout << std::setw(10) << label
+	      << std::setw(10) << tStream
+	      << std::setw(10) << tFast
+	      << "   (" << sink << ")\n";
+}
+
+static int makeInt( int i ) { return i * 7919 - 1000000; }
+static double makeDouble( int i ) { return i * 0.1 + 1.0 / (i + 3); }
+
+/**
+   Compares s11n::Detail::variant's numeric fast paths with the
+   stream-based lexical casting they replace.
+*/
+static void benchVariant()
+{
+    const int count = 200000;
+    std::cout << "Lexical cast round trips of " << count << " values (ms):\n"
+	      << std::setw(10) << "type"
+	      << std::setw(10) << "stream"
+	      << std::setw(10) << "fast"
+	      << '\n';
+    timeLexicalCast<int>( "int", count, makeInt );
+    timeLexicalCast<double>( "double", count, makeDouble );
+}
+
+int main( int argc, char ** argv )
+{
+    QApplication app( argc, argv );
+    QStringList which( app.arguments() );
+    which.removeFirst();
+    try
+    {
+	if( which.isEmpty() || which.contains("sceneindex") ) benchSceneIndex();
+	if( which.isEmpty() || which.contains("variant") ) benchVariant();
+	return 0;
+    }
+    catch( std::exception const & ex )
+    {
+	std::cerr << argv[0] << ": EXCEPTION: " << ex.what() << '\n';
+    }
+    return 1;
+}
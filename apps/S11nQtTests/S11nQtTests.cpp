@@ -2,11 +2,20 @@
 #include <QDebug>
 #include <QString>
 #include <QFile>
+#include <QClipboard>
+#include <QMimeData>
 
 #include <functional>
 #include <algorithm>
 #include <iterator>
 #include <iostream>
+#include <sstream>
+#include <fstream>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstring>
+#include <limits>
 
 #include <s11n.net/s11n/s11nlite.hpp>
 #include <s11n.net/s11n/s11n_debuggering_macros.hpp>
@@ -50,8 +59,55 @@
 #include "S11nQt/QTransform.h"
 #include "S11nQt/QVariant.h"
 #include "S11nQt/Stream.h"
+#include "S11nQt/S11nClipboard.h"
+
+#include "Serializable.h"
+#include "QGIPiece.h"
+#include "QGIDot.h"
+#include "QGIHtml.h"
+#include "Dice.h"
 
 #include <s11n.net/s11n/proxy/pod/int.hpp>
+#include <s11n.net/s11n/io/binary_serializer.hpp>
+#include <s11n.net/s11n/io/funtxt_serializer.hpp>
+#include <s11n.net/s11n/io/funxml_serializer.hpp>
+#include <s11n.net/s11n/io/parens_serializer.hpp>
+#include <s11n.net/s11n/io/strtool.hpp>
+#include <s11n.net/zfstream/zfstream_config.hpp>
+#if HAVE_ZLIB
+#  include <s11n.net/zfstream/pzstream.hpp>
+#endif
+
+/**
+   Returns true if a and b have the same names, class names,
+   properties, blobs and (recursively) children.
+*/
+static bool sameNodes( S11nNode const & a, S11nNode const & b )
+{
+    typedef s11nlite::node_traits NT;
+    if( (NT::name(a) != NT::name(b))
+	|| (NT::class_name(a) != NT::class_name(b)) ) return false;
+    NT::property_map_type const & pa( NT::properties(a) );
+    NT::property_map_type const & pb( NT::properties(b) );
+    if( pa.size() != pb.size() ) return false;
+    NT::property_map_type::const_iterator pit = pa.begin();
+    for( ; pa.end() != pit; ++pit )
+    {
+	NT::property_map_type::const_iterator other = pb.find( (*pit).first );
+	if( (pb.end() == other) || ((*other).second != (*pit).second) ) return false;
+    }
+    if( NT::blobs(a) != NT::blobs(b) ) return false;
+    NT::child_list_type const & ca( NT::children(a) );
+    NT::child_list_type const & cb( NT::children(b) );
+    if( ca.size() != cb.size() ) return false;
+    NT::child_list_type::const_iterator ait = ca.begin();
+    NT::child_list_type::const_iterator bit = cb.begin();
+    for( ; ca.end() != ait; ++ait, ++bit )
+    {
+	if( ! sameNodes( **ait, **bit ) ) return false;
+    }
+    return true;
+}
 
 void try_s11n()
 {
@@ -341,6 +397,458 @@ void try_s11n()
 	s11nlite::save(p2,std::cout);
     }
 
+    if(1)
+    { // binary_serializer round trips
+	using namespace s11n::io;
+	typedef binary_serializer<S11nNode> BinSer;
+	COUT << "binary_serializer:\n";
+	// Varints, around each 7-bit boundary:
+	unsigned long const nums[] = {
+	0, 1, 127, 128, 255, 16383, 16384, 2097151, 2097152,
+	0x7fffffffUL, 0xffffffffUL, static_cast<unsigned long>(-1)
+	};
+	unsigned int const numCount = sizeof(nums)/sizeof(nums[0]);
+	{
+	    std::ostringstream os;
+	    for( unsigned int i = 0; i < numCount; ++i ) binary::write_uint( os, nums[i] );
+	    std::string const buf( os.str() );
+	    std::istringstream is( buf );
+	    for( unsigned int i = 0; i < numCount; ++i )
+	    {
+		if( binary::read_uint( is ) != nums[i] ) THROW("binary: varint round trip failed!");
+	    }
+	    if( EOF != is.peek() ) THROW("binary: varints were not all consumed!");
+	}
+	// A tree with repeated names (name table), embedded NULs and
+	// values long enough to need multi-byte lengths:
+	S11nNode root;
+	NT::name( root, "root" );
+	NT::class_name( root, "RootClass" );
+	std::string nuls( "a\0b\0\0c", 6 );
+	NT::set( root, "nuls", nuls );
+	NT::set( root, "empty", std::string() );
+	NT::set( root, std::string("key\0with\0nuls",13), std::string("\0",1) );
+	std::string big;
+	for( int i = 0; i < 20000; ++i ) big += char( i % 256 );
+	NT::set( root, "big", big );
+	std::string b64;
+	for( int i = 0; i < 200; ++i ) b64 += "Zm9vYmFy";
+	NT::set( root, "b64", b64 + "Zm9vYmE=" );
+	NT::blobs( root )["blob"].assign( big.data(), big.size() );
+	NT::blobs( root )["empty"] = s11n::blob();
+	for( int i = 0; i < 5; ++i )
+	{
+	    S11nNode * ch = NT::create( (i % 2) ? "odd" : "even" );
+	    NT::class_name( *ch, "ChildClass" );
+	    NT::set( *ch, "nuls", nuls );
+	    NT::set( *ch, "i", i );
+	    NT::children( root ).push_back( ch );
+	    NT::children( *ch ).push_back( NT::create( "grandkid" ) );
+	}
+	BinSer ser;
+	std::ostringstream os;
+	if( ! ser.serialize( root, os ) ) THROW("binary: serialize() failed!");
+	std::string const data( os.str() );
+	{
+	    std::istringstream is( data );
+	    std::auto_ptr<S11nNode> back( ser.deserialize( is ) );
+	    if( ! back.get() || ! sameNodes( root, *back ) ) THROW("binary: stream round trip changed the tree!");
+	}
+	{ // the same via the classloader, as s11nlite::load_node() does it
+	    std::istringstream is( data );
+	    std::auto_ptr<S11nNode> back( s11nlite::load_node( is ) );
+	    if( ! back.get() || ! sameNodes( root, *back ) ) THROW("binary: load_node() round trip changed the tree!");
+	}
+	{ // via a file name
+	    std::string const fname( "S11nQtTests-binary.s11n" );
+	    {
+		std::ofstream of( fname.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+		of << data;
+	    }
+	    std::auto_ptr<S11nNode> back( ser.deserialize( fname ) );
+	    std::remove( fname.c_str() );
+	    if( ! back.get() || ! sameNodes( root, *back ) ) THROW("binary: file round trip changed the tree!");
+	}
+	{ // property values are stored as-is, even if they look like base64
+	    if( std::string::npos == data.find( b64 + "Zm9vYmE=" ) ) THROW("binary: base64-like value was altered!");
+	}
+	{ // blobs are stored raw
+	    if( std::string::npos == data.find( big + '\0' ) ) THROW("binary: blob was not stored raw!");
+	}
+	{ // the name table must store each name once
+	    std::string::size_type at = data.find( "ChildClass" );
+	    if( (std::string::npos == at) || (std::string::npos != data.find( "ChildClass", at + 1 )) )
+	    {
+		THROW("binary: name table did not de-duplicate class names!");
+	    }
+	}
+	// Every truncation of the data must fail loudly, not yield a
+	// partial tree:
+	std::string::size_type const dataStart = data.find( '\n' ) + 1;
+	for( std::string::size_type len = dataStart; len < data.size(); ++len )
+	{
+	    std::string const cut( data, 0, len );
+	    bool threw = false;
+	    try
+	    {
+		std::istringstream is( cut );
+		std::auto_ptr<S11nNode> back( ser.deserialize( is ) );
+		threw = ! back.get();
+	    }
+	    catch( s11n::io_exception const & )
+	    {
+		threw = true;
+	    }
+	    if( ! threw )
+	    {
+		CERR << "Truncating binary data at "<<len<<" of "<<data.size()<<" bytes was not detected.\n";
+		THROW("binary: truncated input was not detected!");
+	    }
+	}
+	COUT << "binary_serializer: all round trips passed.\n";
+    }
+
+    if(1)
+    { // blobs through every serializer
+	COUT << "blobs:\n";
+	{ // base64 (RFC 4648 test vectors)
+	    char const * plain[] = { "", "f", "fo", "foo", "foob", "fooba", "foobar" };
+	    char const * coded[] = { "", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy" };
+	    std::string out;
+	    for( unsigned int i = 0; i < 7; ++i )
+	    {
+		s11n::base64_encode( plain[i], std::strlen(plain[i]), out );
+		if( out != coded[i] ) THROW("blobs: base64_encode() failed!");
+		if( ! s11n::base64_decode( coded[i], std::strlen(coded[i]), out ) || (out != plain[i]) )
+		{
+		    THROW("blobs: base64_decode() failed!");
+		}
+	    }
+	    // Non-canonical text would not encode back the same:
+	    if( s11n::base64_decode( "Zm9vYh==", 8, out ) ) THROW("blobs: decoded stray bits!");
+	    if( s11n::base64_decode( "Zm9vYmF\n", 8, out ) ) THROW("blobs: decoded a newline!");
+	    if( s11n::base64_decode( "Zm9v=mFy", 8, out ) ) THROW("blobs: decoded inner padding!");
+	}
+	{ // crc32c() check value, whole and in pieces
+	    char const * check = "123456789";
+	    if( 0xe3069283UL != s11n::crc32c( check, 9 ) ) THROW("blobs: wrong crc32c()!");
+	    if( 0xe3069283UL != s11n::crc32c( check + 4, 5, s11n::crc32c( check, 4 ) ) ) THROW("blobs: crc32c() in pieces differs!");
+	}
+	std::string bytes;
+	for( int i = 0; i < 5000; ++i ) bytes += char( (i * 7) % 256 );
+	S11nNode root;
+	NT::class_name( root, "Blobs" );
+	NT::set( root, "plain", "not a blob" );
+	NT::blobs( root )["bytes"].assign( bytes.data(), bytes.size() );
+	NT::blobs( root )["empty"] = s11n::blob();
+	S11nNode * ch = NT::create( "kid" );
+	NT::children( root ).push_back( ch );
+	NT::blobs( *ch )["nul"].assign( "\0", 1 );
+	char const * sers[] = { "funtxt", "funxml", "parens", "binary", 0 };
+	const std::string oldSer( s11nlite::serializer_class() );
+	for( int i = 0; sers[i]; ++i )
+	{
+	    s11nlite::serializer_class( sers[i] );
+	    std::ostringstream os;
+	    if( ! s11nlite::save( root, os ) ) THROW("blobs: save failed!");
+	    std::istringstream is( os.str() );
+	    std::auto_ptr<S11nNode> back( s11nlite::load_node( is ) );
+	    if( ! back.get() || ! sameNodes( root, *back ) )
+	    {
+		CERR << "Serializer "<<sers[i]<<" did not round-trip:\n"<<os.str()<<'\n';
+		THROW("blobs: serializer round trip changed the data!");
+	    }
+	    if( NT::is_set( *back, "bytes" ) ) THROW("blobs: a blob came back as a property!");
+	}
+	s11nlite::serializer_class( oldSer );
+	{ // a damaged blob must not load
+	    s11n::blob b;
+	    b.assign( bytes.data(), bytes.size() );
+	    std::string text( b.to_text() );
+	    text[text.size() - 10] = ('A' == text[text.size() - 10]) ? 'B' : 'A';
+	    bool threw = false;
+	    try { b.from_text( text ); }
+	    catch( s11n::s11n_exception const & ) { threw = true; }
+	    if( ! threw ) THROW("blobs: damaged data passed its checksum!");
+	    if( b.data() != bytes ) THROW("blobs: failed from_text() changed the blob!");
+	    if( b.from_text( "plain text" ) ) THROW("blobs: plain text was read as a blob!");
+	}
+	COUT << "blobs: all round trips passed.\n";
+    }
+
+    if(1)
+    { // s11n_node's child index
+	COUT << "s11n_node child index:\n";
+	S11nNode parent;
+	S11nNode const & cparent( parent );
+	const int count = 40; // well above the linear-search threshold
+	for( int i = 0; i < count; ++i )
+	{
+	    std::ostringstream nm;
+	    nm << "c" << i;
+	    S11nNode * ch = NT::create( nm.str() );
+	    NT::set( *ch, "i", i );
+	    NT::children( parent ).push_back( ch );
+	}
+	S11nNode * dupe = NT::create( "c7" ); // must never shadow the first c7
+	NT::children( parent ).push_back( dupe );
+	// Non-const children() discards the index, so grab the
+	// children first and only use const access from here on.
+	std::vector<S11nNode*> const kids( NT::children( parent ).begin(), NT::children( parent ).end() );
+	for( int i = 0; i < count; ++i )
+	{
+	    std::ostringstream nm;
+	    nm << "c" << i;
+	    S11nNode const * ch = s11n::find_child_by_name( cparent, nm.str() );
+	    if( ! ch || (NT::get( *ch, "i", -1 ) != i) ) THROW("child index: lookup failed!");
+	}
+	if( s11n::find_child_by_name( cparent, "nope" ) ) THROW("child index: found a missing child!");
+	// Renaming an indexed child must be seen by the next lookup:
+	NT::name( *kids[3], "renamed" );
+	if( s11n::find_child_by_name( cparent, "renamed" ) != kids[3] ) THROW("child index: renamed child not found!");
+	if( s11n::find_child_by_name( cparent, "c3" ) ) THROW("child index: found a child by its old name!");
+	// Renaming the first c7 must expose the second one:
+	NT::name( *kids[7], "c7x" );
+	if( s11n::find_child_by_name( cparent, "c7" ) != dupe ) THROW("child index: duplicate name not found after rename!");
+	// ... and renaming a child to a later child's name must make it the one found:
+	NT::name( *kids[5], "c9" );
+	if( s11n::find_child_by_name( cparent, "c9" ) != kids[5] ) THROW("child index: wrong duplicate found!");
+	// swap() renames both nodes:
+	kids[10]->swap( *kids[11] );
+	S11nNode const * c10 = s11n::find_child_by_name( cparent, "c10" );
+	if( ! c10 || (NT::get( *c10, "i", -1 ) != 10) ) THROW("child index: swap() confused the index!");
+	// Adding a child discards the index:
+	NT::children( parent ).push_back( NT::create( "late" ) );
+	if( ! s11n::find_child_by_name( cparent, "late" ) ) THROW("child index: new child not found!");
+	COUT << "s11n_node child index: all lookups passed.\n";
+    }
+
+    if(1)
+    { // entity translation round trips
+	using namespace s11n::io;
+	COUT << "entity translation:\n";
+	typedef strtool::entity_map EM;
+	EM const * maps[] = {
+	&funxml_serializer_translations(),
+	&parens_serializer_translations(),
+	&funtxt_serializer_translations(),
+	0
+	};
+	char const * samples[] = {
+	"", "plain", "&amp;lt;", "&&;;", "<a href=\"x\">'y'</a>",
+	"(paren) \\(escaped\\) \\\\", "line\none\r\ttab", "&lt;&gt;&amp;&quot;&apos;",
+	0
+	};
+	for( int m = 0; maps[m]; ++m )
+	{
+	    for( int i = 0; samples[i]; ++i )
+	    {
+		std::string str( samples[i] );
+		strtool::translate_entities( str, *maps[m], false );
+		strtool::translate_entities( str, *maps[m], true );
+		if( str != samples[i] )
+		{
+		    CERR << "map #"<<m<<": ["<<samples[i]<<"] came back as ["<<str<<"]\n";
+		    THROW("entities: forward/reverse translation is not a round trip!");
+		}
+	    }
+	}
+	{ // a replacement must not be decoded a second time
+	    EM em;
+	    em["&"] = "&amp;";
+	    em["<"] = "&lt;";
+	    std::string str( "&amp;lt;" );
+	    strtool::translate_entities( str, em, true );
+	    if( str != "&lt;" ) THROW("entities: reverse translation decoded twice!");
+	}
+	// The same through the text serializers. funtxt is left out:
+	// its lexer treats a backslash at the end of a line as a line
+	// continuation, so it cannot store newlines or trailing
+	// backslashes, whatever the entity map does.
+	S11nNode src;
+	NT::class_name( src, "Entities" );
+	for( int i = 0; samples[i]; ++i )
+	{
+	    std::ostringstream key;
+	    key << "s" << i;
+	    NT::set( src, key.str(), std::string( samples[i] ) );
+	}
+	char const * sers[] = { "funxml", "parens", 0 };
+	const std::string oldSer( s11nlite::serializer_class() );
+	for( int i = 0; sers[i]; ++i )
+	{
+	    s11nlite::serializer_class( sers[i] );
+	    std::ostringstream os;
+	    if( ! s11nlite::save( src, os ) ) THROW("entities: save failed!");
+	    std::istringstream is( os.str() );
+	    std::auto_ptr<S11nNode> back( s11nlite::load_node( is ) );
+	    if( ! back.get() || ! sameNodes( src, *back ) )
+	    {
+		CERR << "Serializer "<<sers[i]<<" did not round-trip:\n"<<os.str()<<'\n';
+		THROW("entities: serializer round trip changed the data!");
+	    }
+	}
+	s11nlite::serializer_class( oldSer );
+	COUT << "entity translation: all round trips passed.\n";
+    }
+
+    if(1)
+    { // float properties at the edge of float's range
+	COUT << "float properties:\n";
+	float const fmax = std::numeric_limits<float>::max();
+	S11nNode node;
+	NT::set( node, "max", "3.4028235e38" );
+	NT::set( node, "min", "-3.4028235e38" );
+	NT::set( node, "short", "3.40282e+38" );
+	NT::set( node, "inf", "3.5e38" );
+	if( fmax != NT::get( node, "max", 0.0f ) ) THROW("float: FLT_MAX, as printed in full, did not parse!");
+	if( -fmax != NT::get( node, "min", 0.0f ) ) THROW("float: -FLT_MAX did not parse!");
+	std::istringstream is( "3.40282e+38" );
+	float viaStream = 0;
+	is >> viaStream;
+	if( viaStream != NT::get( node, "short", 0.0f ) ) THROW("float: parse differs from the stream's!");
+	if( 1.0f != NT::get( node, "inf", 1.0f ) ) THROW("float: out-of-range value was not rejected!");
+	COUT << "float properties: passed.\n";
+    }
+
+#if HAVE_ZLIB
+    if(1)
+    { // multi-member gzip from opzstream, read back by izstream
+	COUT << "opzstream/izstream:\n";
+	std::string data;
+	for( int i = 0; data.size() < 700 * 1024; ++i )
+	{ // compressible but not trivially so
+	    std::ostringstream line;
+	    line << "line " << i << ": " << (i * 7919 % 10007) << '\n';
+	    data += line.str();
+	}
+	std::ostringstream zos;
+	{
+	    zfstream::opzstream os( zos, zfstream::ZLibCompression, -1, 3 );
+	    os.write( data.data(), static_cast<std::streamsize>( data.size() ) );
+	    os.close();
+	    if( ! os.good() ) THROW("opzstream: compressing failed!");
+	}
+	std::string const gz( zos.str() );
+	int members = 0;
+	for( std::string::size_type at = 0;
+	     std::string::npos != (at = gz.find( "\x1f\x8b\x08", at ));
+	     ++at ) ++members;
+	if( members < 2 ) THROW("opzstream: expected several gzip members!");
+	{
+	    std::istringstream is( gz );
+	    zfstream::izstream zis( is );
+	    std::ostringstream back;
+	    back << zis.rdbuf();
+	    if( back.str() != data ) THROW("izstream: multi-member data did not round-trip!");
+	}
+	{ // and a node tree, through the same stream helpers the app uses
+	    S11nNode root;
+	    NT::class_name( root, "Compressed" );
+	    NT::set( root, "data", data );
+	    std::ostringstream os;
+	    {
+		zfstream::opzstream zs( os, zfstream::ZLibCompression, -1, 2 );
+		if( ! s11nlite::save( root, zs ) ) THROW("opzstream: save failed!");
+	    }
+	    std::istringstream is( os.str() );
+	    std::auto_ptr<std::istream> zis( zfstream::get_istream( is ) );
+	    if( ! zis.get() ) THROW("zfstream::get_istream() returned no decompressor!");
+	    std::auto_ptr<S11nNode> back( s11nlite::load_node( *zis ) );
+	    if( ! back.get() || ! sameNodes( root, *back ) ) THROW("opzstream: node tree did not round-trip!");
+	}
+	COUT << "opzstream/izstream: "<<members<<" gzip members read back.\n";
+    }
+#endif
+
+    if(1)
+    { // clone() gives the same node as a serialize()/deserialize() round trip
+	COUT << "clone():\n";
+	QPixmap px( 32, 32 );
+	px.fill( Qt::red );
+	QGIPiece piece;
+	piece.setProperty( "pos", QPointF( 10, 20 ) );
+	piece.setProperty( "zLevel", 3 );
+	piece.setProperty( "color", QColor( Qt::blue ) );
+	piece.setProperty( "borderColor", QColor( Qt::green ) );
+	piece.setProperty( "borderSize", 2 );
+	piece.setProperty( "pixmap", px );
+	QGIPiece * kid = new QGIPiece;
+	kid->setParentItem( &piece );
+	kid->setProperty( "pos", QPointF( 5, 5 ) );
+	kid->setProperty( "color", QColor( Qt::white ) );
+	QGIDot dot;
+	dot.setProperty( "pos", QPointF( -4, 8 ) );
+	dot.setProperty( "color", QColor( Qt::yellow ) );
+	QGIHtml html;
+	html.setHtml( "<b>bold</b> text" );
+	html.setProperty( "pos", QPointF( 7, 7 ) );
+	QGIDie die;
+	die.setProperty( "pos", QPointF( 1, 2 ) );
+	Serializable const * items[] = { &piece, &dot, &html, &die };
+	char const * names[] = { "QGIPiece", "QGIDot", "QGIHtml", "QGIDie" };
+	for( unsigned int i = 0; i < sizeof(items)/sizeof(items[0]); ++i )
+	{
+	    std::auto_ptr<Serializable> cl( items[i]->clone() );
+	    std::auto_ptr<Serializable> rt( items[i]->Serializable::clone() );
+	    if( ! cl.get() || ! rt.get() ) THROW("clone(): cloning failed!");
+	    S11nNode a;
+	    S11nNode b;
+	    if( ! cl->serialize( a ) || ! rt->serialize( b ) ) THROW("clone(): serializing a clone failed!");
+	    if( ! sameNodes( a, b ) )
+	    {
+		CERR << names[i] << "::clone() differs from a serialize()/deserialize() round trip.\n";
+		s11nlite::save( a, std::cerr );
+		s11nlite::save( b, std::cerr );
+		THROW("clone(): clone differs from a serialize()/deserialize() round trip!");
+	    }
+	}
+	COUT << "clone(): all clones match their round trips.\n";
+    }
+
+    if(1)
+    { // S11nClipboard publishes lazily and does not re-read its own data
+	COUT << "S11nClipboard:\n";
+	S11nClipboard & cb( S11nClipboard::instance() );
+	QClipboard * qcb = QApplication::clipboard();
+	S11nNode n;
+	NT::name( n, "clip" );
+	NT::class_name( n, "ClipClass" );
+	NT::set( n, "a", 1 );
+	cb.slotCopy( &n );
+	QApplication::processEvents();
+	S11nNode * mine = cb.contents();
+	if( ! mine || ! sameNodes( n, *mine ) ) THROW("S11nClipboard: slotCopy() did not set the contents!");
+	QMimeData const * md = qcb->mimeData();
+	if( ! md || ! md->hasFormat( S11nClipboard::MimeType ) || ! md->hasFormat( "text/plain" ) )
+	{
+	    THROW("S11nClipboard: the Qt clipboard does not offer our formats!");
+	}
+	// Nothing is serialized until the data is asked for, so a
+	// change made after copying must show up in it:
+	NT::set( *mine, "late", 2 );
+	QByteArray const bytes( md->data( S11nClipboard::MimeType ) );
+	std::auto_ptr<S11nNode> back;
+	{
+	    std::istringstream is( std::string( bytes.constData(), bytes.size() ) );
+	    back.reset( s11nlite::load_node( is ) );
+	}
+	if( ! back.get() || ! sameNodes( *mine, *back ) ) THROW("S11nClipboard: the published data is not the current contents!");
+	if( md->data( "text/plain" ) != bytes ) THROW("S11nClipboard: text/plain differs from the s11n data!");
+	QApplication::processEvents();
+	if( cb.contents() != mine ) THROW("S11nClipboard: re-read its own data!");
+	// Data from elsewhere replaces the contents:
+	NT::set( n, "a", 3 );
+	std::ostringstream os;
+	if( ! s11nlite::save( n, os ) ) THROW("S11nClipboard: save failed!");
+	qcb->setText( QString::fromUtf8( os.str().c_str() ) );
+	QApplication::processEvents();
+	if( ! cb.contents() || ! sameNodes( n, *cb.contents() ) ) THROW("S11nClipboard: did not read foreign data!");
+	cb.slotClear();
+	if( cb.contents() ) THROW("S11nClipboard: slotClear() left contents!");
+	COUT << "S11nClipboard: all checks passed.\n";
+    }
+
 }
 
 int main(int argc, char ** argv)
@@ -3,5 +3,5 @@ TEMPLATE = subdirs
 SUBDIRS = QBoard
 unix:contains(QBOARD_VERSION,^0$){
 # only build for a dev tree...
-  SUBDIRS += S11nQtTests QBoardScript WikiLiteParser
+  SUBDIRS += S11nQtTests QBoardScript WikiLiteParser QBoardBench
 }
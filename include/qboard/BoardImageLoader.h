@@ -0,0 +1,118 @@
+#ifndef QBOARD_BOARDIMAGELOADER_H_INCLUDED
+#define QBOARD_BOARDIMAGELOADER_H_INCLUDED 1
+/*
+ * This file is (or was, at some point) part of the QBoard project
+ * (http://code.google.com/p/qboard)
+ *
+ * Copyright (c) 2008 Stephan Beal (http://wanderinghorse.net/home/stephan/)
+ *
+ * This file may be used under the terms of the GNU General Public
+ * License versions 2.0 or 3.0 as published by the Free Software
+ * Foundation and appearing in the files LICENSE.GPL2 and LICENSE.GPL3
+ * included in the packaging of this file.
+ *
+ */
+
+#include <QThread>
+#include <QImage>
+#include <QRect>
+#include <QSize>
+#include <QString>
+
+/**
+   BoardImageLoader decodes a (typically huge) board image on a worker
+   thread and hands it to the GUI thread in pieces:
+
+   - First a low-resolution preview. Formats which support scaled
+   decoding natively (e.g. JPEG) get it cheaply via
+   QImageReader::setScaledSize(). For the others (e.g. PNG) it is
+   scaled down from the full image, so the file is decoded only
+   once.
+
+   - Then the full-resolution image, in chunks of ChunkSize x
+   ChunkSize pixels, so that the GUI thread can convert and paint
+   them a bit at a time instead of blocking on one huge QPixmap
+   conversion.
+
+   Only QImages cross the thread boundary. Converting them to
+   QPixmaps is left to the receivers, in the GUI thread.
+
+   The object deletes itself when its thread finishes, so clients
+   must not delete it while it is running. To abandon a load, call
+   cancel() and disconnect from it.
+*/
+class BoardImageLoader : public QThread
+{
+Q_OBJECT
+public:
+    /**
+       The edge length, in pixels, of the chunks sent via
+       tileLoaded().
+    */
+    static const int ChunkSize = 512;
+    /**
+       The maximum edge length of the preview image.
+    */
+    static const int PreviewSize = 1024;
+
+    /**
+       Prepares to load the given file. Call start() to start
+       loading it.
+    */
+    explicit BoardImageLoader( QString const & fileName );
+    /**
+       Cancels the load and waits for the thread to finish.
+    */
+    virtual ~BoardImageLoader();
+
+    QString fileName() const;
+
+    /**
+       Returns the size of the image in the given file, as reported
+       by the image reader without decoding the image. Returns an
+       invalid size if the format cannot tell without decoding it (or
+       the file is not a readable image).
+    */
+    static QSize imageSize( QString const & fileName );
+
+public Q_SLOTS:
+    /**
+       Asks the loader to stop as soon as possible. It cannot
+       interrupt the image decoder itself, but no further signals
+       are emitted once the current step finishes.
+    */
+    void cancel();
+
+Q_SIGNALS:
+    /**
+       Emitted (at most once) with a scaled-down version of the image
+       and the size of the full image.
+    */
+    void previewLoaded( QImage const & preview, QSize const & fullSize );
+    /**
+       Emitted for each full-resolution chunk of the image. where is
+       the chunk's position in the full image.
+    */
+    void tileLoaded( QImage const & tile, QRect const & where );
+    /**
+       Emitted if the image cannot be read.
+    */
+    void loadFailed( QString const & why );
+    /**
+       Emitted after the last tileLoaded() signal of a successful,
+       uncancelled load.
+    */
+    void loadFinished();
+
+protected:
+    virtual void run();
+
+private:
+    BoardImageLoader( BoardImageLoader const & ); // not implemented!
+    BoardImageLoader & operator=( BoardImageLoader const & ); // not implemented!
+    bool cancelled() const;
+    struct Impl;
+    Impl * impl;
+};
+
+#endif // QBOARD_BOARDIMAGELOADER_H_INCLUDED
@@ -55,6 +55,8 @@ public:
 	virtual bool serialize( S11nNode & dest ) const;
 	/** Deserializes src to this object. */
 	virtual bool deserialize( S11nNode const & src );
+	/** Returns a copy of this die, made without a serialization round trip. */
+	virtual Serializable * clone() const;
 	virtual int type() const { return QGITypes::QGIDie; }
 	QRectF boundingRect() const;
     QPainterPath shape() const;
@@ -22,6 +22,7 @@ class QBoard;
 class QGraphicsItem;
 class QScriptEngine;
 #include <QScriptValue>
+class S11nFileThread;
 
 /**
    GameState is the central point of a QBoard game. It holds the
@@ -45,6 +46,12 @@ class QScriptEngine;
    s11nSave() member and use s11nLoad() to load its contents from a
    file or stream.
 
+   Interactive clients should prefer loadAsync() and saveAsync(),
+   which do the file I/O and parsing/formatting on a worker thread
+   and report back via ioProgress(), loadFinished() and
+   saveFinished(). Those are also available to JS code via the
+   global qboard object.
+
 */
 class GameState : public QObject,
 		  public Serializable
@@ -71,9 +78,24 @@ public:
     to rebuild the QObject ownership heirarchy. This also allows
     parenting Serializables to get away with some weird tricks
     (e.g. see QGILineBinder).
+
+    - Embedded images (QPixmaps) used by any of the above, each
+    distinct image stored only once, in a "pixmaps" child (see
+    s11n::qt::QPixmapTable). The objects using them only store a
+    reference to the table entry. Builds from before the table was
+    added cannot load the images from such files. Clipboard data
+    still embeds each image in the object using it.
     */
     virtual bool serialize( S11nNode & dest ) const;
-    /** Deserializes src to this object. */
+    /** Deserializes src to this object.
+
+    If batchedLoading() is true, the graphics items are
+    deserialized immediately but are added to the scene
+    afterwards, a time-slice at a time, from the event loop (see
+    MaterializeSliceMs). itemsMaterialized() is emitted when they
+    have all been added. In either mode, the scene's item index is
+    suspended while the items are added.
+    */
     virtual bool deserialize( S11nNode const & src );
 
     /**
@@ -81,6 +103,12 @@ public:
     */
     QGraphicsScene * scene();
 
+    /**
+       Returns the name of the scene's item index strategy: one of
+       "auto", "bsp" or "none". See QBoardScene::IndexMode.
+    */
+    Q_INVOKABLE QString sceneIndexMode() const;
+
 //     QList<QObject*> selectedObjects();
 //     QList<Serializable*> selectedSerializables();
 
@@ -102,6 +130,35 @@ public:
     */
     QScriptEngine & jsEngine() const;
 
+    /**
+       Returns true while a loadAsync() or saveAsync() is running.
+    */
+    Q_INVOKABLE bool isBusy() const;
+
+    /**
+       Returns the reason the last loadAsync() or saveAsync() failed,
+       or an empty string if it did not.
+    */
+    Q_INVOKABLE QString ioErrorString() const;
+
+    /**
+       Returns true if batched loading is enabled. See
+       setBatchedLoading().
+    */
+    Q_INVOKABLE bool batchedLoading() const;
+
+    /**
+       Returns true while items from a batched deserialize() or a
+       loadAsync() are still being added to the scene.
+    */
+    Q_INVOKABLE bool isMaterializing() const;
+
+    /**
+       Batched loads add items to the scene for at most this many
+       milliseconds per event loop pass.
+    */
+    static const int MaterializeSliceMs = 15;
+
 public Q_SLOTS:
     /**
        Enables a specially-treated "placemarker" item. It can be moved
@@ -132,6 +189,13 @@ public Q_SLOTS:
     */
     void setPlacementPos( QPointF const & );
 
+    /**
+       Sets the scene's item index strategy. m must be one of "auto"
+       (the default), "bsp" or "none". See QBoardScene::IndexMode for
+       the trade-offs. This setting is saved along with the game.
+    */
+    void setSceneIndexMode( QString const & m );
+
     /**
        If it returns true, it transfers ownership of the item to this
        object's QGraphicsScene, otherwise the caller owns the item.
@@ -154,14 +218,98 @@ public Q_SLOTS:
     void clipPaste();
     void selectAll();
 
+    /**
+       Starts loading the given game file. The file is read and
+       parsed on a worker thread, then the game is rebuilt from it
+       in the GUI thread, in time-slices of MaterializeSliceMs, with
+       the event loop running in between. loadFinished() is emitted
+       when it is done.
+
+       Returns false if another load or save is running, else true.
+       Note that the current game is cleared only once the file has
+       been parsed successfully.
+    */
+    bool loadAsync( QString const & fn );
+
+    /**
+       Starts saving this game to the given file. The game is
+       serialized to an S11nNode tree immediately (this has to happen
+       in the GUI thread), then formatted and written to disk on a
+       worker thread. saveFinished() is emitted when it is done.
+
+       autoAddFileExtension is as for s11nSave().
+
+       Returns false if another load or save is running or if
+       serialization fails, else true.
+    */
+    bool saveAsync( QString const & fn, bool autoAddFileExtension = true );
+
+    /**
+       Cancels a running loadAsync() or saveAsync(). A cancelled load
+       leaves the game empty if it had already been cleared, and a
+       cancelled save leaves the target file untouched. The
+       corresponding *Finished() signal is emitted with ok=false.
+    */
+    void cancelIO();
+
+    /**
+       Enables or disables batched materialization in deserialize().
+       It is disabled by default because clients of deserialize()
+       traditionally expect the items to be in the scene when it
+       returns. loadAsync() always loads in batches.
+    */
+    void setBatchedLoading( bool );
+
+Q_SIGNALS:
+    /**
+       Emitted while loadAsync() or saveAsync() is running. If total
+       is 0 the current step (reading/parsing or formatting/writing
+       the file) cannot report its progress. Otherwise done of total
+       items have been loaded.
+    */
+    void ioProgress( int done, int total );
+    /**
+       Emitted when a loadAsync() finishes, fails, or is cancelled.
+    */
+    void loadFinished( QString const & fileName, bool ok );
+    /**
+       Emitted when a saveAsync() finishes, fails, or is cancelled.
+       fileName is the name the game was saved to, including any
+       automatically-added file extension.
+    */
+    void saveFinished( QString const & fileName, bool ok );
+    /**
+       Emitted when the items of a batched deserialize() or a
+       loadAsync() have all been added to the scene (ok=true), or
+       when that was cancelled or failed (ok=false).
+    */
+    void itemsMaterialized( bool ok );
+
 private Q_SLOTS:
     void placemarkerDestroyed();
+    /** Handles completion of the S11nFileThread job. */
+    void ioJobDone( bool ok );
+    /** Adds the next time-slice worth of items to the scene. */
+    void materializeBatch();
 
 private:
     GameState & operator=(GameState const &); // not implemented!
     GameState(GameState const &); // not implemented!
     /** internal detail. */
     void setup();
+    /**
+       Does all of deserialize() except creating the graphics
+       items.
+    */
+    bool deserializeSetup( S11nNode const & src );
+    /** Starts adding queued/pending items from the event loop. */
+    void startMaterializing();
+    /** Stops materializing and drops the remaining items. */
+    void stopMaterializing();
+    /** Ends materialization and emits the appropriate signals. */
+    void finishMaterializing( bool ok );
+    /** Stops and deletes the S11nFileThread job, if any. */
+    void abortIO();
     /** internal detail. */
     bool pasteTryHarder( S11nNode const & root,
 			 QPoint const & pos );
@@ -0,0 +1,107 @@
+#ifndef QBOARD_LineStyle_H_INCLUDED
+#define QBOARD_LineStyle_H_INCLUDED 1
+/*
+ * This file is (or was, at some point) part of the QBoard project
+ * (http://code.google.com/p/qboard)
+ *
+ * Copyright (c) 2008 Stephan Beal (http://wanderinghorse.net/home/stephan/)
+ *
+ * This file may be used under the terms of the GNU General Public
+ * License versions 2.0 or 3.0 as published by the Free Software
+ * Foundation and appearing in the files LICENSE.GPL2 and LICENSE.GPL3
+ * included in the packaging of this file.
+ *
+ */
+
+#include <QColor>
+#include <QPen>
+#include <QVariant>
+
+namespace qboard {
+
+    /**
+       LineStyle is a typed cache of the style properties of the line
+       items (QGILineBinder, QGIDotLine), so that they can paint
+       without looking up QObject properties by name on every frame.
+
+       The owning item calls set() from its
+       QEvent::DynamicPropertyChange handler, and reads the members
+       when painting.
+
+       The properties are:
+
+       - color (QColor). Its alpha is replaced by alpha.
+
+       - alpha (or colorAlpha): an integer 0-255, or a fraction up to
+       1.0 (as used by QColor::setAlphaF()).
+
+       - width (qreal).
+
+       - style: a Qt::PenStyle, as a number or a name (see
+       s11n::qt::stringToPenStyle()).
+
+       - drawArrows (int, treated as a bool) and arrowSize (qreal).
+
+       Setting a property to an invalid QVariant restores its default.
+    */
+    struct LineStyle
+    {
+	/**
+	   Which members a set() call changed. Geometry is set for
+	   changes which affect the item's bounding rectangle.
+	*/
+	enum Changes {
+	NoChange = 0,
+	Appearance = 0x01,
+	Geometry = 0x02
+	};
+
+	QColor color;
+	int alpha;
+	qreal width;
+	Qt::PenStyle style;
+	bool drawArrows;
+	qreal arrowSize;
+
+	/**
+	   Sets the defaults used for properties which are not set
+	   (or set to invalid QVariants).
+	*/
+	LineStyle( QColor const & color = QColor(Qt::black),
+		   qreal width = 2,
+		   Qt::PenStyle style = Qt::SolidLine,
+		   qreal arrowSize = 12 );
+
+	/**
+	   Updates the member for the given property name from val.
+	   Returns a combination of Changes values; NoChange if key is
+	   not a style property.
+	*/
+	int set( char const * key, QVariant const & val );
+
+	/**
+	   Copies the color, alpha, width and style from pen. This is
+	   for items which (de)serialize a QPen instead of their
+	   properties.
+	*/
+	void setPen( QPen const & pen );
+
+	/** Returns color with this object's alpha applied. */
+	QColor effectiveColor() const;
+
+	/**
+	   Returns base with this object's color, width and style
+	   applied. base supplies the rest (caps, joins, dashes).
+	*/
+	QPen pen( QPen const & base = QPen() ) const;
+
+    private:
+	QColor defColor;
+	qreal defWidth;
+	Qt::PenStyle defStyle;
+	qreal defArrowSize;
+    };
+
+} // namespace qboard
+
+#endif // QBOARD_LineStyle_H_INCLUDED
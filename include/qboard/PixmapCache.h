@@ -0,0 +1,106 @@
+#ifndef QBOARD_PIXMAPCACHE_H_INCLUDED
+#define QBOARD_PIXMAPCACHE_H_INCLUDED 1
+/*
+ * This file is (or was, at some point) part of the QBoard project
+ * (http://code.google.com/p/qboard)
+ *
+ * Copyright (c) 2008 Stephan Beal (http://wanderinghorse.net/home/stephan/)
+ *
+ * This file may be used under the terms of the GNU General Public
+ * License versions 2.0 or 3.0 as published by the Free Software
+ * Foundation and appearing in the files LICENSE.GPL2 and LICENSE.GPL3
+ * included in the packaging of this file.
+ *
+ */
+
+#include <QPixmap>
+#include <QString>
+#include <QSize>
+
+namespace qboard
+{
+    /**
+       PixmapCache is a process-wide cache of pixmaps loaded from
+       files. Loading the same image file any number of times decodes
+       it only once: all callers get a copy of the same implicitly
+       shared QPixmap, so a deck of 500 identical counters holds one
+       copy of the image data, not 500.
+
+       Entries are keyed by the file's canonical path plus its
+       modification time, so editing an image on disk and re-loading
+       it picks up the new version. The cache holds at most budget()
+       kilobytes of decoded pixmap data and evicts the least recently
+       used entries when that is exceeded. Eviction only drops the
+       cache's own reference: pixmaps still in use by items stay alive
+       until those items let go of them.
+
+       Like QPixmap itself, this class must only be used from the GUI
+       thread.
+    */
+    class PixmapCache
+    {
+    public:
+	/**
+	   Returns the shared instance.
+	*/
+	static PixmapCache & instance();
+
+	/**
+	   Returns the pixmap stored in the given file, loading it if
+	   it is not already cached. Returns a null pixmap if the file
+	   cannot be loaded. Failed loads are not cached.
+	*/
+	QPixmap load( QString const & fileName );
+
+	/**
+	   Like load(fileName), but returns a copy scaled to the given
+	   size. The scaled copy is cached separately from the
+	   original (which is not cached by this call).
+	*/
+	QPixmap load( QString const & fileName, QSize const & scaledTo );
+
+	/**
+	   Looks up a pixmap stored using insert(). If found, dest is
+	   set to it and true is returned, otherwise dest is not
+	   modified and false is returned.
+	*/
+	bool find( QString const & key, QPixmap & dest );
+
+	/**
+	   Adds an arbitrary pixmap (e.g. a pre-rendered piece) to the
+	   cache under the given key. Such entries share the budget
+	   and LRU ordering with file-based entries. To avoid
+	   collisions with the file entries, keys should start with a
+	   class-specific prefix, e.g. "QGIPiece|...".
+	*/
+	void insert( QString const & key, QPixmap const & pix );
+
+	/**
+	   Sets the maximum amount of decoded pixmap data, in
+	   kilobytes, which the cache will hold on to. If the
+	   current content is larger, LRU entries are evicted
+	   immediately.
+	*/
+	void setBudget( int kbytes );
+
+	/**
+	   Returns the current budget, in kilobytes.
+	*/
+	int budget() const;
+
+	/**
+	   Removes all entries from the cache.
+	*/
+	void clear();
+
+    private:
+	PixmapCache();
+	~PixmapCache();
+	PixmapCache( PixmapCache const & ); // not implemented!
+	PixmapCache & operator=( PixmapCache const & ); // not implemented!
+	struct Impl;
+	Impl * impl;
+    };
+}
+
+#endif // QBOARD_PIXMAPCACHE_H_INCLUDED
@@ -0,0 +1,80 @@
+#ifndef QBOARD_PropertyID_H_INCLUDED
+#define QBOARD_PropertyID_H_INCLUDED 1
+/*
+ * This file is (or was, at some point) part of the QBoard project
+ * (http://code.google.com/p/qboard)
+ *
+ * Copyright (c) 2008 Stephan Beal (http://wanderinghorse.net/home/stephan/)
+ *
+ * This file may be used under the terms of the GNU General Public
+ * License versions 2.0 or 3.0 as published by the Free Software
+ * Foundation and appearing in the files LICENSE.GPL2 and LICENSE.GPL3
+ * included in the packaging of this file.
+ *
+ */
+
+#include <QByteArray>
+
+namespace qboard {
+
+    /**
+       IDs for the QObject properties which QBoard's game items give
+       special meaning to. Item types switch on these in their
+       DynamicPropertyChange handlers instead of comparing strings.
+
+       When adding a property, add it here and in propertyID() and
+       propertyName().
+    */
+    enum PropertyID {
+    PropUnknown = 0,
+    PropAlpha, // also "colorAlpha", the older name
+    PropAngle,
+    PropArrowSize,
+    PropBorderAlpha,
+    PropBorderColor,
+    PropBorderSize,
+    PropBorderStyle,
+    PropColor,
+    PropDragDisabled,
+    PropDrawArrows,
+    PropHtml,
+    PropLow,
+    PropPixmap,
+    PropPos,
+    PropRadius,
+    PropScale,
+    PropSides,
+    PropSize,
+    PropStyle,
+    PropWidth,
+    PropZLevel,
+    PropEND
+    };
+
+    /**
+       Returns the ID of the given property name, or PropUnknown.
+
+       The lookup is a hand-written perfect hash: it switches on
+       the name's length and one or two of its characters, and
+       then confirms the one possible candidate with memcmp(). It
+       neither allocates nor takes locks, so it is cheap enough to
+       call for every property change.
+    */
+    PropertyID propertyID( char const * name );
+
+    /**
+       Same as propertyID(char const *), but uses name.size()
+       instead of strlen(). Handy with
+       QDynamicPropertyChangeEvent::propertyName().
+    */
+    PropertyID propertyID( QByteArray const & name );
+
+    /**
+       Returns the (current) property name for the given ID, or 0
+       for PropUnknown and out-of-range values.
+    */
+    char const * propertyName( PropertyID id );
+
+} // namespace qboard
+
+#endif // QBOARD_PropertyID_H_INCLUDED
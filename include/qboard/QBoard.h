@@ -17,7 +17,9 @@
 #include <QObject>
 #include <QRectF>
 #include <QSize>
+#include <QImage>
 #include <qboard/Serializable.h>
+class BoardImageLoader;
 
 /**
 	QBoard is the basic game board type for the QBoard app.
@@ -51,17 +53,69 @@ public Q_SLOTS:
     /**
        Tries to load the given pixmap, returning true on success,
        false on error.
+
+       Very large images (see ProgressiveLoadThreshold) are loaded
+       progressively on a worker thread. In that case this function
+       returns true as soon as the load has started, pixmap() has
+       the full image's size but is filled in a bit at a time, and
+       loadedBoard() is emitted when the preview is available and
+       again when the load is complete. boardRegionLoaded() is
+       emitted for each piece in between.
     */
     bool loadPixmap( QString const & );
     /**
        Clears the state of the board.
     */
     void clear();
+    /**
+       Returns true if a progressive load is currently running.
+    */
+    bool isLoading() const;
+
+    /**
+       Images with at least this many pixels are loaded
+       progressively by loadPixmap().
+    */
+    static const int ProgressiveLoadThreshold = 4 * 1024 * 1024;
+
 Q_SIGNALS:
+	/**
+	   Emitted when pixmap() has been replaced. During a
+	   progressive load this is emitted when the low-res preview
+	   has been painted into pixmap() and again when loading has
+	   finished.
+	*/
 	void loadedBoard();
+	/**
+	   Emitted during a progressive load whenever the given area
+	   of pixmap() has been filled in at full resolution.
+	*/
+	void boardRegionLoaded( QRect const & );
+private Q_SLOTS:
+	void loaderPreview( QImage const &, QSize const & );
+	void loaderTile( QImage const &, QRect const & );
+	void loaderFailed( QString const & );
+	void loaderFinished();
 private:
+	/**
+	   Starts a progressive load of fn if it is big enough to
+	   warrant one. Returns false if it is not.
+	*/
+	bool startProgressiveLoad( QString const & fn );
+	/**
+	   Abandons a running progressive load, if any.
+	*/
+	void cancelLoad();
+	/**
+	   Returns true if the current signal comes from the current
+	   loader (as opposed to an abandoned one whose queued signals
+	   are still arriving).
+	*/
+	bool fromCurrentLoader() const;
 	QString m_file;
 	QPixmap m_px;
+	BoardImageLoader * m_loader;
+	QSize m_loadSize;
 };
 // Register QBoard with s11n:
 #define S11N_TYPE QBoard
@@ -3,8 +3,10 @@
 
 #include <QObject>
 #include <QGraphicsScene>
+#include <QString>
 class QPainter;
 class QWidget;
+class QGraphicsSceneMouseEvent;
 #include <QGraphicsItem>
 #include <QStyleOptionGraphicsItem>
 
@@ -15,6 +17,27 @@ class QBoardScene : public QGraphicsScene,
 {
 Q_OBJECT
 public:
+    /**
+       The item indexing strategies supported by QBoardScene.
+
+       - IndexAuto: the scene periodically samples its item count and
+       how many items are being dragged around, and switches between
+       the other two modes on its own. This is the default.
+
+       - IndexBsp: always use Qt's BSP tree index. Hit tests,
+       collidingItems() and exposed-region painting are logarithmic,
+       but every item move has to update the tree.
+
+       - IndexNone: never index. Every hit test is a linear scan of
+       all items, but moving items costs nothing extra. This is what
+       QBoard used exclusively before IndexAuto existed.
+    */
+    enum IndexMode {
+    IndexAuto = 0,
+    IndexBsp,
+    IndexNone
+    };
+
     QBoardScene();
     virtual ~QBoardScene();
 
@@ -28,6 +51,95 @@ public:
     */
     virtual bool deserialize( S11nNode const & src );
 
+    /**
+       Sets the index strategy. Setting IndexBsp or IndexNone applies
+       that mode immediately and disables adaptive switching.
+    */
+    void setIndexMode( IndexMode );
+    /**
+       Returns the index strategy set via setIndexMode(). Note that
+       when this returns IndexAuto, itemIndexMethod() tells which
+       index is currently active.
+    */
+    IndexMode indexMode() const;
+
+    /**
+       Turns off item indexing until a matching resumeIndex() call,
+       so that adding or removing many items at once does not pay
+       for index maintenance on each one. Calls may be nested.
+       setIndexMode() may still be called while the index is
+       suspended; it takes effect on resume.
+    */
+    void suspendIndex();
+    /**
+       Ends a suspendIndex(). When the last suspension ends, the
+       index mode is re-applied. In IndexAuto mode the choice is
+       made immediately, based on the new item count, instead of
+       waiting for the next samples.
+    */
+    void resumeIndex();
+    /**
+       Returns true between suspendIndex() and the matching
+       resumeIndex().
+    */
+    bool isIndexSuspended() const;
+
+    /**
+       Converts one of "auto", "bsp" or "none" (case-insensitive) to
+       an IndexMode. Unknown strings map to IndexAuto.
+    */
+    static IndexMode indexModeFromString( QString const & );
+    /**
+       The opposite of indexModeFromString().
+    */
+    static QString indexModeToString( IndexMode );
+
+    /**
+       Moves the given items to the top of the stacking order, above
+       all other top-level items, while keeping their order relative to
+       each other. Items which have a parent item or are not in this
+       scene are ignored. Returns true if any item's zValue() changed,
+       or false if the items were already on top.
+
+       The scene keeps the z-levels of its top-level items in an ordered
+       map, so this costs O(k log n) for k items in a scene of n items,
+       instead of a scan of all colliding items. Code which adds or
+       removes items, or sets z-levels by other means (e.g. by loading
+       a game or via a "zLevel" property), must call
+       invalidateZOrder(), and the next raise or lower rebuilds the
+       map from the scene. The map is also rebuilt periodically. A
+       rebuild calls normalizeZLevels() if the z-levels have drifted
+       too far apart or collide.
+    */
+    bool raiseItems( QList<QGraphicsItem*> const & items );
+    /** Same as raiseItems(), for a single item. */
+    bool raiseItem( QGraphicsItem * item );
+    /**
+       The opposite of raiseItems(): moves the items below all other
+       top-level items.
+    */
+    bool lowerItems( QList<QGraphicsItem*> const & items );
+    /** Same as lowerItems(), for a single item. */
+    bool lowerItem( QGraphicsItem * item );
+    /**
+       Drops the z-order map used by raiseItems() and lowerItems(),
+       so that the next call to either rebuilds it from the scene's
+       items. See raiseItems() for when to call this.
+    */
+    void invalidateZOrder();
+    /**
+       If item is in a QBoardScene, calls that scene's
+       invalidateZOrder().
+    */
+    static void invalidateZOrder( QGraphicsItem * item );
+    /**
+       Reassigns the z-levels of all top-level items to evenly spaced
+       values, starting at 0, without changing their stacking order.
+       Items with equal z-levels keep the order in which Qt paints
+       them.
+    */
+    void normalizeZLevels();
+
 protected:
     virtual void drawItems( QPainter * painter,
 			    int numItems,
@@ -35,7 +147,37 @@ protected:
 			    const QStyleOptionGraphicsItem * options,
 			    QWidget * widget = 0 );
     bool event( QEvent * event );
+    virtual void mousePressEvent( QGraphicsSceneMouseEvent * event );
+    virtual void mouseMoveEvent( QGraphicsSceneMouseEvent * event );
+private Q_SLOTS:
+    /**
+       Used by IndexAuto mode to re-evaluate which index to use.
+    */
+    void sampleIndexUsage();
 private:
+    /**
+       Rebuilds the z-order map from the scene's items if it has
+       not been built since the last invalidateZOrder(), or if
+       enough raise/lower operations have passed that it may have
+       missed changes nobody reported. The interval grows with the
+       item count, so the O(n) rescan costs O(1) per operation on
+       average.
+    */
+    void zMaybeRescan();
+    /**
+       The zoomed-out part of drawItems(): pieces which are smaller
+       than QGIPiece::LodClusterPixels on screen, and whose centers
+       fall in the same LodClusterPixels-sized cell of the view, are
+       drawn as one cluster glyph at the stacking position of the
+       topmost of them. Everything else is drawn normally, in
+       order. Returns false, having drawn nothing, if there was
+       nothing to cluster.
+    */
+    bool drawClusters( QPainter * painter,
+		       int numItems,
+		       QGraphicsItem ** items,
+		       const QStyleOptionGraphicsItem * options,
+		       QWidget * widget );
     struct Impl;
     Impl * impl;
 };
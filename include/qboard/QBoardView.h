@@ -64,6 +64,8 @@ public Q_SLOTS:
     void setGLMode(bool);
 private Q_SLOTS:
 	void updateBoardPixmap();
+	/** Repaints the given (scene-coordinate) area of the board. */
+	void updateBoardRegion( QRect const & );
 
 protected:
 	virtual void drawBackground( QPainter *, const QRectF & );
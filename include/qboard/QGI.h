@@ -42,9 +42,11 @@ struct QGITypes
 
     /**
        If the event is a left click then item is moved to the top of
-       the view stack via adjustment of its zLevel, based on the
-       zLevel of all items intersecting the item. It it is a
-       middle click the item is moved to the bottom of the stack.
+       the view stack via adjustment of its zLevel (see raiseItem()).
+       It it is a middle click the item is moved to the bottom of the
+       stack. If item is part of a multi-item selection then the
+       whole selection is raised or lowered, keeping its internal
+       order, so that a stack of selected pieces stays together.
 
        This routine does NOT call ev->accept().
 
@@ -53,6 +55,17 @@ struct QGITypes
     static bool handleClickRaise( QGraphicsItem * item,
 				  QGraphicsSceneMouseEvent * ev );
 
+    /**
+       Moves item to the top (or, if high is false, the bottom) of the
+       stacking order. For top-level items in a QBoardScene this uses
+       the scene's z-order map (see QBoardScene::raiseItems()).
+       Otherwise it falls back to qboard::nextZLevel(), which only
+       considers the items colliding with item.
+
+       Returns true if it modified the zlevel, otherwise false.
+    */
+    static bool raiseItem( QGraphicsItem * item, bool high = true );
+
     /**
        Randomly shuffles the positions of all items in the given
        list. It will not introduce new positions - it randomly
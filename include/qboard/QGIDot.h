@@ -36,6 +36,11 @@ QGIDot();
     QPainterPath shape() const;
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
     virtual bool event( QEvent * e );
+    /**
+       Returns a copy of this dot, made without a serialization
+       round trip. Child lines (and the dots they lead to) are
+       cloned via their own clone().
+    */
     virtual Serializable * clone() const;
 Q_SIGNALS:
     void dotDestructing( QGIDot * );
@@ -60,6 +60,12 @@ public:
     */
     virtual bool deserialize( S11nNode const & src );
 
+    /**
+       Returns a copy of this object which hides a clone of the
+       currently hidden item.
+    */
+    virtual Serializable * clone() const;
+
     virtual int type() const { return QGITypes::QGIHider; }
 
     /**
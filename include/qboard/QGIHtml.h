@@ -37,6 +37,11 @@ public:
     virtual bool serialize( S11nNode & dest ) const;
     /** Deserializes src to this object. */
     virtual bool deserialize( S11nNode const & src );
+    /**
+       Returns a copy of this object. The text document is copied
+       directly instead of being re-parsed from HTML.
+    */
+    virtual Serializable * clone() const;
     virtual int type() const { return QGITypes::QGIHtml; }
 public Q_SLOTS:
    /**
@@ -83,6 +83,32 @@ public:
     */
     virtual bool deserialize( S11nNode const & src );
 
+    /**
+       Returns a copy of this piece and its children, made without
+       a serialization round trip. The copy shares this piece's
+       pixmap.
+    */
+    virtual Serializable * clone() const;
+
+    /**
+       Level-of-detail thresholds, in device pixels along a piece's
+       longer side. Pieces smaller than LodSwatchPixels on screen
+       paint a flat swatchColor() rectangle instead of their image.
+       Stacks of pieces smaller than LodClusterPixels are drawn as a
+       single glyph by QBoardScene.
+    */
+    static const int LodSwatchPixels = 6;
+    /** See LodSwatchPixels. */
+    static const int LodClusterPixels = 3;
+
+    /**
+       Returns the average color of this piece's rendered
+       appearance (background, pixmap and border), for drawing it
+       when it is too small to show any detail. The result is
+       cached until the appearance changes.
+    */
+    QColor swatchColor() const;
+
 Q_SIGNALS:
     void doubleClicked( QGraphicsItem * );
 
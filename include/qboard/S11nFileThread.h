@@ -0,0 +1,124 @@
+#ifndef QBOARD_S11NFILETHREAD_H_INCLUDED
+#define QBOARD_S11NFILETHREAD_H_INCLUDED 1
+/*
+ * This file is (or was, at some point) part of the QBoard project
+ * (http://code.google.com/p/qboard)
+ *
+ * Copyright (c) 2008 Stephan Beal (http://wanderinghorse.net/home/stephan/)
+ *
+ * This file may be used under the terms of the GNU General Public
+ * License versions 2.0 or 3.0 as published by the Free Software
+ * Foundation and appearing in the files LICENSE.GPL2 and LICENSE.GPL3
+ * included in the packaging of this file.
+ *
+ */
+
+#include <QThread>
+#include <QString>
+#include <qboard/S11n.h>
+
+/**
+   S11nFileThread does the file-bound half of loading or saving an
+   S11nNode tree on a worker thread:
+
+   - Load mode parses a file into a new S11nNode tree.
+
+   - Save mode formats an existing S11nNode tree and writes it to a
+   file. The data are written to a temporary file (the target name
+   plus ".part") which atomically replaces the target only if the
+   write succeeds, so a failed or cancelled save never clobbers an
+   existing file. If the final rename fails, the temporary file is
+   kept and errorString() names it.
+
+   The serializer is picked by the constructors, so they must be
+   called from the thread which otherwise uses s11nlite (normally
+   the GUI thread). The text parsers still share some global state
+   (their lexer classloader and lexer-to-builder map) with any
+   parsing done in the GUI thread. s11n::io::parse_lock serializes
+   all such parses, so a parse in the GUI thread (e.g. of the
+   clipboard) waits while a file is being parsed.
+
+   Only the node tree crosses the thread boundary. Building objects
+   from it (or building it from objects) is left to the client, in
+   the GUI thread, since QGraphicsItems and QPixmaps may only be
+   touched there.
+
+   The client owns this object. When the work is done, jobDone() is
+   emitted and the client should wait() on and then delete the
+   thread.
+*/
+class S11nFileThread : public QThread
+{
+Q_OBJECT
+public:
+    enum Mode {
+    Load = 0,
+    Save
+    };
+
+    /**
+       Prepares to load the given file. Call start() to start
+       loading it.
+    */
+    explicit S11nFileThread( QString const & fileName );
+    /**
+       Prepares to save root to the given file. This object takes
+       over ownership of root. Call start() to start saving.
+    */
+    S11nFileThread( QString const & fileName, S11nNode * root );
+    /**
+       Cancels the job, waits for the thread to finish, and deletes
+       any node this object still owns.
+    */
+    virtual ~S11nFileThread();
+
+    Mode mode() const;
+    QString fileName() const;
+
+    /**
+       Transfers ownership of the loaded node tree to the caller. It
+       returns 0 if the load failed or was cancelled, if the thread
+       is still running, or if takeNode() was already called.
+    */
+    S11nNode * takeNode();
+
+    /**
+       Returns a description of why the job failed, or an empty
+       string if it did not.
+    */
+    QString errorString() const;
+
+    /**
+       Returns true if cancel() was called before the job finished.
+    */
+    bool wasCancelled() const;
+
+public Q_SLOTS:
+    /**
+       Asks the job to stop. The s11n parser and formatter cannot be
+       interrupted, so the current step runs to completion, but its
+       results are discarded: a cancelled load returns no node and a
+       cancelled save leaves the target file untouched.
+    */
+    void cancel();
+
+Q_SIGNALS:
+    /**
+       Emitted from the worker thread when the job has finished, with
+       ok set to true if it succeeded and was not cancelled.
+    */
+    void jobDone( bool ok );
+
+protected:
+    virtual void run();
+
+private:
+    S11nFileThread( S11nFileThread const & ); // not implemented!
+    S11nFileThread & operator=( S11nFileThread const & ); // not implemented!
+    bool runLoad();
+    bool runSave();
+    struct Impl;
+    Impl * impl;
+};
+
+#endif // QBOARD_S11NFILETHREAD_H_INCLUDED
@@ -15,12 +15,18 @@ namespace s11n { namespace qt {
     struct QByteArray_s11n
     {
 	/**
-	   Serializes src to dest, saving the data in a bin64-encoded
-	   string. If src.size() is greater than
+	   Serializes src to dest. If src.size() is greater than
 	   QByteArray_s11n::compressionThreshold then the serialized
-	   copy is compressed using qCompress() before bin64 encoding
-	   is applied.
-	   
+	   copy is compressed using qCompress().
+
+	   The (maybe compressed) bytes are saved in a blob (see
+	   s11n::blob) named "data", plus a "z" flag saying whether
+	   they are compressed. Binary serializers save the blob as
+	   raw bytes, text serializers as base64.
+
+	   The deserialize operator also reads the base64 text with
+	   a djb2 checksum which older versions saved.
+
 	   See the compressionThreshold for more info.
 	*/
 	bool operator()( S11nNode & dest, QByteArray const & src ) const;
@@ -70,6 +70,52 @@ namespace s11n { namespace qt {
 	return ret;
     }
 
+    /**
+       Like deserializeQGIList(), but fills dest with clones of
+       the items in src, made via SerializableT::clone(), instead
+       of rebuilding them from serialized data. Items which cannot
+       be cast to a (SerializableT*) are skipped, as
+       serializeQGIList() does, and clones which are not
+       QGraphicsItems are destroyed. SerializableT::clone() must
+       return a (SerializableT*).
+
+       Returns the number of cloned items, or -1 if cloning any
+       item fails, in which case the clones made so far are
+       destroyed and dest is not modified.
+    */
+    template <typename SerializableT>
+    int cloneQGIList( QList<QGraphicsItem *> const & src,
+		      QList<QGraphicsItem*> & dest,
+		      QGraphicsItem * parent = 0,
+		      QGraphicsItem::GraphicsItemFlags flags = 0 )
+    {
+	typedef QList<QGraphicsItem *> QGIL;
+	QGIL clones;
+	for( QGIL::const_iterator it = src.begin();
+	     src.end() != it; ++it )
+	{
+	    SerializableT const * ser = dynamic_cast<SerializableT const *>(*it);
+	    if( ! ser ) continue;
+	    SerializableT * cl = ser->clone();
+	    if( ! cl )
+	    {
+		qDeleteAll( clones );
+		return -1;
+	    }
+	    QGraphicsItem * qgi = dynamic_cast<QGraphicsItem *>(cl);
+	    if( ! qgi )
+	    {
+		s11n::cleanup_serializable( cl );
+		continue;
+	    }
+	    if( parent ) qgi->setParentItem( parent );
+	    if( flags ) qgi->setFlags( flags );
+	    clones.push_back(qgi);
+	}
+	dest += clones;
+	return clones.size();
+    }
+
 }}
 
 #endif
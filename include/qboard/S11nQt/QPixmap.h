@@ -1,15 +1,103 @@
 #ifndef S11NQT_QPixmap_H_INCLUDED
 #define S11NQT_QPixmap_H_INCLUDED 1
 #include <QPixmap>
+#include <string>
 namespace s11n { namespace qt {
 /* s11n proxy for QPixmap.*/
 struct QPixmap_s11n
 {
-  /** Serializes src to dest. */
+  /**
+     Serializes src to dest. If a QPixmapTable is current then
+     the image is added to that table and dest only gets a
+     "ref" property naming it.
+  */
   bool operator()( S11nNode & dest, QPixmap const & src ) const;
-  /** Deserializes dest from src. */
+  /**
+     Deserializes dest from src. Data written as a "ref" can
+     only be read while a QPixmapTable holding that image is
+     current, so nodes which must stand on their own (clipboard
+     contents, clones) are written with no table current.
+  */
   bool operator()( S11nNode const & src, QPixmap & dest ) const;
 };
+
+/**
+   QPixmapTable stores each distinct image in a serialized tree
+   only once.
+
+   While a table is current (see Scope), QPixmap_s11n encodes
+   each image it is given into the table instead of into the
+   node it is serializing, and writes only the image's id. The
+   id is derived from a hash of the encoded data, so identical
+   images get the same id even if they were loaded separately.
+   The table is then saved with serialize(), typically as a
+   child of the same tree.
+
+   For loading, deserialize() the table before the objects which
+   refer to it and make it current while those objects are
+   deserialized. Each image is decoded once, the first time it
+   is referenced, and all of the pixmaps read from it share that
+   one QPixmap's data.
+
+   QPixmaps may only be used from the GUI thread, and so may
+   this class.
+*/
+class QPixmapTable
+{
+public:
+    QPixmapTable();
+    ~QPixmapTable();
+    /**
+       Adds px to the table, unless an identical image is
+       already in it, and returns its id. Returns an empty
+       string if px cannot be encoded.
+    */
+    std::string add( QPixmap const & px );
+    /**
+       Returns the image with the given id, or a null pixmap if
+       there is none.
+    */
+    QPixmap lookup( std::string const & id );
+    /** Returns the number of images in the table. */
+    int count() const;
+    /** Removes all images. */
+    void clear();
+    /** Saves the table's images to dest. */
+    bool serialize( S11nNode & dest ) const;
+    /**
+       Replaces the table's contents with the images stored in
+       src by serialize(). The images are only decoded by
+       lookup().
+    */
+    bool deserialize( S11nNode const & src );
+    /** Returns the current table, or 0 if there is none. */
+    static QPixmapTable * current();
+    /**
+       Makes a table current for the lifetime of a Scope.
+       Scopes may nest; destroying one restores the table
+       which was current before it.
+    */
+    class Scope
+    {
+    public:
+	explicit Scope( QPixmapTable & t );
+	/**
+	   Makes no table current, so that pixmaps are serialized
+	   inline even while a game is being saved or loaded.
+	*/
+	Scope();
+	~Scope();
+    private:
+	QPixmapTable * prev;
+	Scope( Scope const & );
+	Scope & operator=( Scope const & );
+    };
+private:
+    struct Impl;
+    Impl * impl;
+    QPixmapTable( QPixmapTable const & );
+    QPixmapTable & operator=( QPixmapTable const & );
+};
 }} // namespace
 /** register s11n proxy for QPixmap. */
 #define S11N_TYPE QPixmap
@@ -15,12 +15,22 @@
 
 #include <QObject>
 #include <s11n.net/s11n/s11nlite.hpp>
+#include <qboard/S11nQt.h>
+#include <qboard/S11nQt/QPixmap.h>
 #include <QDebug>
 
 /**
    S11nClipboard provides clipboard features for any Serializable
    type. It is intended to be used as a Singleton - fetch its instance
    via the static instance() function.
+
+   The clipboard content is kept as a live S11nNode. When it is set,
+   the Qt clipboard is only told which formats are available (MimeType
+   and text/plain). The node is serialized the first time another
+   application actually asks for the data, and when the Qt clipboard
+   changes while this process still owns it, the content is not
+   re-read. Thus copying and pasting within one QBoard process never
+   converts the data to text.
 */
 class S11nClipboard : public QObject
 {
@@ -31,6 +41,12 @@ private:
 public:
     typedef s11nlite::node_type S11nNode;
     typedef s11nlite::node_traits S11nNodeTraits;
+    /**
+       The MIME type under which the clipboard content is published
+       to other applications, in s11nlite's current serializer
+       format. It is also published as text/plain.
+    */
+    static char const * MimeType;
     /**
        Returns the shared instance of S11nClipboard.
     */
@@ -87,6 +103,7 @@ public:
 	{
 	    S11nNode tmp;
 	    S11nNodeTraits::name( tmp, "S11nClipboardData" );
+	    s11n::qt::QPixmapTable::Scope inlinePixmaps;
 	    ret = s11nlite::serialize( tmp, ser );
 	    if( ret )
 	    {
@@ -131,11 +148,14 @@ Q_SIGNALS:
     */
     void signalUpdated();
 private Q_SLOTS:
-    /** Copies the local s11n clipboard data to the Qt clipboard as text and emits signalUpdated(). */
+    /** Publishes the local s11n clipboard data to the Qt clipboard
+    (see the class docs) and emits signalUpdated(). */
     void syncToQt();
-    /** Reads the text content from the Qt clipboard and tries to
-    deserialize it, replacing the current data. If the source cannot
-    be deserialized then this clipboard is cleared. */
+    /** Reads the MimeType or text content from the Qt clipboard and
+    tries to deserialize it, replacing the current data. If the source
+    cannot be deserialized then this clipboard is cleared. Does
+    nothing if the Qt clipboard holds the data this object last
+    published. */
     void syncFromQt();
 private:
     S11nNode * m_node;
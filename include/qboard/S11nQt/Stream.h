@@ -14,7 +14,10 @@
  */
 
 #include <iostream>
+#include <sstream>
+#include <memory>
 #include <QIODevice>
+#include <QString>
 
 namespace s11n { namespace qt {
     /**
@@ -41,6 +44,14 @@ namespace s11n { namespace qt {
        }
        \endcode
 
+       Output is collected in a put area of a configurable size and
+       handed to the QIODevice in blocks, and large writes bypass the
+       buffer altogether, so writing through this proxy costs about
+       the same as writing to a std::ofstream. Buffered output reaches
+       the device when the buffer fills up, when the ostream is
+       flushed (e.g. via std::flush or std::endl), or when this object
+       is destroyed.
+
        Limitations: only write is supported. No lookback, no re-get,
        etc.
     */
@@ -53,36 +64,63 @@ namespace s11n { namespace qt {
 	typedef std::streambuf::char_type char_type;
 	typedef std::streambuf::traits_type traits_type;
 
+	/** The default buffer size, in bytes. */
+	enum { DefaultBufferSize = 1024 * 64 };
+
 	/**
 	   Sets in.rdbuf(this) and sets up to divert
 	   all output to qio_out.
 
 	   If !qio_out.isOpen() then qio_out.open(QIODevice::WriteOnly)
-	   is called. If the device is not open and cannot be opened
-	   then an std::exception is thrown.
+	   is called. If the device is not open for writing and cannot
+	   be opened then an std::exception is thrown.
+
+	   bufferSize is the size of the put area. If it is less than
+	   1 then output is not buffered and each character is passed
+	   on to the device as it is written.
 
 	   The caller is responsible for ensuring that both
 	   streams outlive this object.
 	*/
 	StdToQtOBuf( std::ostream & std_out,
-		     QIODevice & qio_out );
+		     QIODevice & qio_out,
+		     int bufferSize = DefaultBufferSize );
 
 	/**
-	   If the ostream still has this object as its
-	   rdbuf() then this function re-sets the rdbuf
-	   to its original state.
+	   Flushes any buffered output to the device. If the ostream
+	   still has this object as its rdbuf() then this function
+	   re-sets the rdbuf to its original state.
 
 	   This does not close the associated streams.
 	*/
 	virtual ~StdToQtOBuf();
 
 	/**
-	   If !traits_type::not_eof(c) then it writes c to the QIODevice
-	   and returns true, else is does nothing and returns
-	   false. traits_type::eof().
+	   Flushes the put area to the QIODevice and then, unless c is
+	   traits_type::eof(), stores c in the put area (or writes it
+	   directly if output is not buffered). Returns
+	   traits_type::eof() on a write error, else some other value.
 	*/
 	virtual int overflow(int c);
+
+    protected:
+	/**
+	   Writes n bytes from src. Blocks at least as big as the
+	   put area are written directly to the device. Returns the
+	   number of bytes written, which is only less than n on error.
+	*/
+	virtual std::streamsize xsputn( char_type const * src, std::streamsize n );
+
+	/**
+	   Writes any buffered output to the device and, if it is a
+	   QFile, flushes the file's own buffer. Returns 0 on success
+	   and -1 on error.
+	*/
+	virtual int sync();
+
     private:
+	/** Hands the contents of the put area to the device. */
+	bool flushPutArea();
 	//! Copying not allowed.
 	StdToQtOBuf( const StdToQtOBuf & );
 	//! Copying not allowed.
@@ -112,6 +150,10 @@ namespace s11n { namespace qt {
        }
        \endcode
 
+       Input is read from the device in blocks into a get area of a
+       configurable size, and large reads go straight from the
+       device to the caller's memory.
+
        Limitations: only readahead is supported. No lookahead, no putback,
        etc.
     */
@@ -123,19 +165,27 @@ namespace s11n { namespace qt {
     public:
 	typedef std::streambuf::char_type char_type;
 	typedef std::streambuf::traits_type traits_type;
+
+	/** The default buffer size, in bytes. */
+	enum { DefaultBufferSize = 1024 * 64 };
+
 	/**
 	   Sets std_in.rdbuf(this) and sets up to divert
 	   all output to qio_in.
 
 	   If !qio_in.isOpen() then qio_in.open(QIODevice::ReadOnly)
-	   is called. If the device is not open and cannot be opened
-	   then an std::exception is thrown.
+	   is called. If the device is not open for reading and cannot
+	   be opened then an std::exception is thrown.
+
+	   bufferSize is the size of the get area. Values less than 1
+	   are treated as 1.
 
 	   The caller is responsible for ensuring that both
 	   streams outlive this object.
 	*/
 	StdToQtIBuf( std::istream & std_in,
-		     QIODevice & qio_in );
+		     QIODevice & qio_in,
+		     int bufferSize = DefaultBufferSize );
 	/**
 	   If the istream still has this object as its
 	   rdbuf() then this function re-sets the rdbuf
@@ -150,6 +200,14 @@ namespace s11n { namespace qt {
 	   Fetches the next character(s) from the QIODevice.
 	*/
 	virtual int_type underflow();
+
+	/**
+	   Reads up to n bytes into dest, first from the get area and
+	   then from the device. Reads of at least the buffer size
+	   bypass the buffer. Returns the number of bytes read, which
+	   is less than n only at EOF or on error.
+	*/
+	virtual std::streamsize xsgetn( char_type * dest, std::streamsize n );
     private:
 	//! Copying not allowed.
 	StdToQtIBuf( const StdToQtIBuf & );
@@ -180,8 +238,11 @@ namespace s11n { namespace qt {
 
 	   If proxy is not open in QIODevice::WriteOnly mode, and cannot
 	   be opened in that mode, then an exception is thrown.
+
+	   bufferSize is passed on to StdToQtOBuf.
 	*/
-	QtStdOStream( QIODevice & proxy );
+	QtStdOStream( QIODevice & proxy,
+		      int bufferSize = StdToQtOBuf::DefaultBufferSize );
 	/**
 	   Detaches this object from the constructor-specified proxy.
 	*/
@@ -215,8 +276,11 @@ namespace s11n { namespace qt {
 
 	   If proxy is not open in QIODevice::ReadOnly mode, and cannot be
 	   opened in that mode, then an exception is thrown.
+
+	   bufferSize is passed on to StdToQtIBuf.
 	*/
-	QtStdIStream( QIODevice & proxy );
+	QtStdIStream( QIODevice & proxy,
+		      int bufferSize = StdToQtIBuf::DefaultBufferSize );
 	virtual ~QtStdIStream();
     private:
 	//! Copying not allowed.
@@ -226,6 +290,35 @@ namespace s11n { namespace qt {
 	StdToQtIBuf m_buf;
     };
 
+    /**
+       Sniffs the magic cookie of the given file (decompressing it
+       if needed) and returns a new Serializer which can read it, or
+       0 if none can. The caller owns the returned object.
+
+       This goes through s11nlite's classloader, which is not
+       thread-safe, so call it from the GUI thread.
+    */
+    s11nlite::serializer_interface * serializerFor( QString const & fileName );
+
+    /**
+       Loads a root node from the given file using ser, which must
+       be able to read it (see serializerFor()). If ser is 0 then
+       serializerFor(fileName) is used.
+
+       The file is read through a QFile, so Qt resources work, and
+       is decompressed if needed.
+
+       Returns 0 on error or propagates an exception. The caller
+       owns the returned node.
+
+       When ser is not 0 this does not touch s11nlite's
+       serializer class or classloader, and the parsers lock
+       their shared state (see s11n::io::parse_lock), so it may
+       be called from a worker thread.
+    */
+    S11nNode * loadNode( QString const & fileName,
+			 s11nlite::serializer_interface * ser = 0 );
+
     /**
        Serializes src to dest using libs11n.
        SerializableT must be a non-cv-qualified
@@ -236,7 +329,8 @@ namespace s11n { namespace qt {
     {
 	std::ostringstream dummy;
 	StdToQtOBuf sentry( dummy, dest );
-	return s11nlite::save( src, dummy );
+	return s11nlite::save( src, dummy )
+	    && dummy.flush().good();
     }
 
     /**
@@ -83,6 +83,12 @@ public:
        but i don't like the idea of virtuals having default values.
     */
     virtual bool s11nSave( QString const &, bool autoAddFileExtension ) const;
+
+    /**
+       Returns the name s11nSave(fn,autoAddFileExtension) would save
+       to.
+    */
+    QString s11nSaveName( QString const & fn, bool autoAddFileExtension ) const;
     /**
        Saves this object to the given stream using serialize().
     */
@@ -108,7 +114,16 @@ public:
     /**
        Creates a polymorphic clone of this object via serialization.
 
-       Subclasses may want to do some customization here.
+       Serializing and deserializing can be expensive (e.g. it
+       re-encodes any embedded images), so subclasses may reimplement
+       this to copy their state directly, sharing Qt's implicitly
+       shared data (QPixmap, QPen, QVariant, ...) instead of
+       converting it. Such a clone must end up in the same state as
+       this implementation's serialize()/deserialize() round trip,
+       i.e. serializing it must give the same node as serializing
+       this object, so it should mirror the subclass' serialize()
+       and deserialize(). Subclasses should fall back to this
+       implementation for state they cannot copy directly.
     */
     virtual Serializable * clone() const;
 
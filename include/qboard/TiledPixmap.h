@@ -0,0 +1,92 @@
+#ifndef QBOARD_TILEDPIXMAP_H_INCLUDED
+#define QBOARD_TILEDPIXMAP_H_INCLUDED 1
+/*
+ * This file is (or was, at some point) part of the QBoard project
+ * (http://code.google.com/p/qboard)
+ *
+ * Copyright (c) 2008 Stephan Beal (http://wanderinghorse.net/home/stephan/)
+ *
+ * This file may be used under the terms of the GNU General Public
+ * License versions 2.0 or 3.0 as published by the Free Software
+ * Foundation and appearing in the files LICENSE.GPL2 and LICENSE.GPL3
+ * included in the packaging of this file.
+ *
+ */
+
+#include <QPixmap>
+#include <QRect>
+#include <QRectF>
+class QPainter;
+
+namespace qboard
+{
+    /**
+       TiledPixmap draws a (potentially huge) pixmap, e.g. a scanned
+       game board, as a grid of fixed-size tiles. Only the tiles which
+       intersect the exposed area are drawn, so the per-frame cost
+       depends on the size of the exposed area, not on the size of the
+       pixmap.
+
+       For zoomed-out painters it keeps pre-scaled "mip" levels (each
+       half the size of the one before it) and draws from the level
+       closest to the painter's scale. Mip levels are built lazily, the
+       first time they are needed. Level 0 is the original pixmap
+       itself: its tiles are drawn straight out of it rather than
+       copied, so the full-resolution image is not held twice.
+
+       TiledPixmap does not take a reference to the source pixmap,
+       it only points to it. That allows the owner to paint into the
+       pixmap (e.g. while it is being progressively loaded) without
+       forcing a deep copy of the implicitly shared data.
+    */
+    class TiledPixmap
+    {
+    public:
+	/**
+	   The edge length, in pixels, of each tile.
+	*/
+	static const int TileSize = 256;
+
+	TiledPixmap();
+	~TiledPixmap();
+
+	/**
+	   Sets the pixmap to draw and drops any mip levels built for
+	   the previous one. This object does not own the pixmap, and
+	   it must outlive this object or be replaced via
+	   setPixmap(0) before it dies.
+	*/
+	void setPixmap( QPixmap const * );
+
+	/**
+	   Returns the pixmap set via setPixmap(), or a null pixmap if
+	   none is set.
+	*/
+	QPixmap const & pixmap() const;
+
+	/**
+	   Tells this object that the given area (in pixmap
+	   coordinates) of pixmap() has changed, e.g. because more of
+	   the image has been loaded. Only the matching parts of
+	   already-built mip levels are re-scaled. A null rect means
+	   "all of it", and drops all mip levels.
+	*/
+	void invalidate( QRect const & = QRect() );
+
+	/**
+	   Draws those parts of pixmap() which intersect the exposed
+	   rect. Both the exposed rect and pixmap() are in the
+	   painter's logical coordinates, with pixmap() anchored at
+	   (0,0).
+	*/
+	void draw( QPainter * p, QRectF const & exposed );
+
+    private:
+	TiledPixmap( TiledPixmap const & ); // not implemented!
+	TiledPixmap & operator=( TiledPixmap const & ); // not implemented!
+	struct Impl;
+	Impl * impl;
+    };
+}
+
+#endif // QBOARD_TILEDPIXMAP_H_INCLUDED
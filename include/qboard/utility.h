@@ -106,6 +106,10 @@ namespace qboard
        or similar.
 
        If high is false, then the lowest zLevel is calculated.
+
+       This scans all items colliding with gi, so for top-level items
+       in a QBoardScene prefer QGITypes::raiseItem(), which uses the
+       scene's z-order map.
     */
     qreal nextZLevel( QGraphicsItem const * gi, bool high = true );
 	
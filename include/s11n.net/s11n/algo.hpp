@@ -644,7 +644,13 @@ wrap().memberfunc();
            Ownership of the child does not change by calling this
            function: parent still owns it.
 
-	   Complexity is linear.
+	   This calls lookup_child_by_name( parent, name ), unqualified,
+	   so that node types may supply a faster lookup.
+
+	   Complexity is linear for node types which do not supply
+	   their own lookup_child_by_name(). s11n_node keeps a
+	   hashed index for nodes with many children, which makes
+	   repeated lookups constant-time.
         */
         template <typename NodeT>
         const NodeT *
@@ -667,6 +673,19 @@ wrap().memberfunc();
         NodeT *
         find_child_by_name( NodeT & parent, const std::string & name );
 
+        /**
+           The default implementation of the lookup used by
+           find_child_by_name(): a linear search of parent's
+           children.
+
+           Node types which can do better should overload this
+           function, as a non-template, in their own namespace, where
+           argument-dependent lookup will find it. s11n_node does so.
+        */
+        template <typename NodeT>
+        const NodeT *
+        lookup_child_by_name( const NodeT & parent, const std::string & name );
+
 	namespace debug {
 
 		/**
@@ -57,6 +57,13 @@ s11n::find_child_by_name( NodeT & parent, const std::string & name )
 template <typename NodeT>
 const NodeT *
 s11n::find_child_by_name( const NodeT & parent, const std::string & name )
+{
+	return lookup_child_by_name( parent, name );
+}
+
+template <typename NodeT>
+const NodeT *
+s11n::lookup_child_by_name( const NodeT & parent, const std::string & name )
 {
 	typedef node_traits<NodeT> TR;
 	typedef typename NodeT::child_list_type::const_iterator CIT;
@@ -0,0 +1,121 @@
+#ifndef s11n_BLOB_HPP_INCLUDED
+#define s11n_BLOB_HPP_INCLUDED
+
+////////////////////////////////////////////////////////////////////////
+// blob.hpp
+// Raw binary data in s11n nodes.
+// License: Public Domain
+////////////////////////////////////////////////////////////////////////
+#include <string>
+#include <cstddef> // size_t
+
+#include <s11n.net/s11n/export.hpp>
+
+namespace s11n {
+
+	/**
+	   Returns the CRC-32C (Castagnoli) checksum of the n bytes
+	   at data. To checksum data in pieces, pass the result for
+	   the previous pieces as crc.
+
+	   Uses the SSE4.2 crc32 instruction when the library is
+	   compiled for it, else a slice-by-8 table lookup. Either
+	   way it is several times faster than the djb2 hash
+	   S11nQt's QByteArray proxy used to use.
+	*/
+	S11N_EXPORT_API unsigned long crc32c( void const * data, std::size_t n, unsigned long crc = 0 );
+
+	/**
+	   Stores the base64 encoding (standard alphabet, '='
+	   padding, no line breaks) of n bytes from data in dest.
+	*/
+	S11N_EXPORT_API void base64_encode( void const * data, std::size_t n, std::string & dest );
+
+	/**
+	   Decodes n characters of base64 text at src into dest.
+	   Returns false if the text is not exactly what
+	   base64_encode() would write for some input (e.g. it has
+	   whitespace or stray bits in the last digit), in which case
+	   dest's contents are unspecified.
+	*/
+	S11N_EXPORT_API bool base64_decode( char const * src, std::size_t n, std::string & dest );
+
+	/**
+	   A blob is a block of raw bytes plus their crc32c(). Nodes
+	   hold blobs apart from their (text) properties: see
+	   s11n_node::blobs().
+
+	   Binary serializers write the bytes as-is. Text serializers
+	   write a blob as a property holding its to_text() form, and
+	   their parsers turn such properties back into blobs. Either
+	   way the checksum is saved with the data and checked when
+	   it is read back.
+	*/
+	class S11N_EXPORT_API blob
+	{
+	public:
+		/** An empty blob. */
+		blob();
+
+		/** Copies n bytes from data and checksums them. */
+		blob( void const * data, std::size_t n );
+
+		/** Copies n bytes from data and checksums them. */
+		void assign( void const * data, std::size_t n );
+
+		/**
+		   Takes over the contents of data, which is left
+		   empty, and checks them against crc, the checksum
+		   which was saved with them. Throws an s11n_exception
+		   if it does not match, in which case this object is
+		   not changed.
+		*/
+		void assign( std::string & data, unsigned long crc );
+
+		/** The raw bytes. */
+		std::string const & data() const;
+
+		std::size_t size() const;
+
+		bool empty() const;
+
+		/** The crc32c() of data(). */
+		unsigned long crc() const;
+
+		void swap( blob & rhs );
+
+		bool operator==( blob const & rhs ) const;
+		bool operator!=( blob const & rhs ) const;
+
+		/**
+		   Returns the text form used by text serializers:
+		   prefix(), the checksum as 8 hex digits, a colon,
+		   then the base64-encoded bytes.
+		*/
+		std::string to_text() const;
+
+		/**
+		   If text starts with prefix(), it is parsed as
+		   written by to_text() into this object and true is
+		   returned. Throws an s11n_exception if it starts with
+		   prefix() but is corrupt. Returns false, without
+		   changing this object, if text does not start with
+		   prefix().
+		*/
+		bool from_text( std::string const & text );
+
+		/**
+		   The marker which starts the text form of a blob:
+		   "s11n:blob:crc32c=". Text properties which start
+		   with it are read back as blobs.
+		*/
+		static std::string const & prefix();
+
+	private:
+		std::string m_data;
+		unsigned long m_crc;
+	};
+
+} // namespace s11n
+
+#endif // s11n_BLOB_HPP_INCLUDED
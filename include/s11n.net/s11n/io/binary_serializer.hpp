@@ -0,0 +1,300 @@
+#ifndef s11n_BINARY_SERIALIZER_HPP_INCLUDED
+#define s11n_BINARY_SERIALIZER_HPP_INCLUDED 1
+
+////////////////////////////////////////////////////////////////////////
+// binary_serializer.hpp: a compact, non-text s11n Serializer.
+//
+// License: Public Domain
+////////////////////////////////////////////////////////////////////////
+
+#include <s11n.net/s11n/io/data_node_io.hpp> // data_node_serializer<> class.
+#include <s11n.net/s11n/traits.hpp> // node_traits
+#include <s11n.net/s11n/exception.hpp>
+#include <s11n.net/s11n/s11n_config.hpp>
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+MAGIC_COOKIE_BINARY defines the magic-cookie which prefixes each file
+output by the binary_serializer. It is followed by a single newline,
+after which the data are binary.
+
+Note that this macro is #undef'd at the end of this file, and is
+therefore unavailable to client code.
+*/
+#define MAGIC_COOKIE_BINARY "#s11n::io::binary_serializer 2"
+
+namespace s11n {
+	namespace io {
+
+                namespace sharing {
+                        /**
+                           Sharing context used by binary_serializer.
+                         */
+                        struct binary_sharing_context {};
+                }
+
+		/**
+		   Low-level helpers for binary_serializer. Not part of the
+		   public API.
+
+		   All integers are written as unsigned LEB128 varints
+		   (7 bits per byte, low bits first, high bit set on all
+		   but the last byte), so they are byte-order independent
+		   and small values take one byte.
+		*/
+		namespace binary {
+
+			/** Writes v as a varint. */
+			void write_uint( std::ostream & dest, unsigned long v );
+
+			/**
+			   Reads a varint. Throws an io_exception on EOF or
+			   overflow.
+			*/
+			unsigned long read_uint( std::istream & src );
+
+			/** Writes the length of s, followed by its raw bytes. */
+			void write_bytes( std::ostream & dest, std::string const & s );
+
+			/**
+			   Reads a string written by write_bytes() into
+			   dest. Throws an io_exception on a short read.
+			*/
+			void read_bytes( std::istream & src, std::string & dest );
+
+			/**
+			   Consumes the magic cookie (plus its newline) from
+			   src if it is still there. s11n's cookie-sniffing
+			   load_node(istream) consumes it before handing us
+			   the stream, but loading from a file name does not.
+			   Throws an io_exception if the stream starts with a
+			   different cookie.
+			*/
+			void skip_cookie( std::istream & src, std::string const & cookie );
+
+			/**
+			   Writes names (node names, class names and property
+			   keys) to a stream, each distinct name in full only
+			   the first time it is seen. A name is written as
+			   varint 0 followed by write_bytes(name) the first
+			   time, and as varint (id+1) afterwards, where id is
+			   the order in which it first appeared.
+			*/
+			class name_table_writer
+			{
+			public:
+				name_table_writer();
+				void write( std::ostream & dest, std::string const & name );
+			private:
+				typedef std::map<std::string,unsigned long> map_type;
+				map_type m_ids;
+			};
+
+			/**
+			   The reading counterpart of name_table_writer.
+			*/
+			class name_table_reader
+			{
+			public:
+				name_table_reader();
+				/**
+				   Reads one name reference. The returned
+				   reference is valid until the next call.
+				*/
+				std::string const & read( std::istream & src );
+			private:
+				std::vector<std::string> m_names;
+			};
+
+		} // namespace binary
+
+                /**
+                   binary_serializer is a compact binary format for
+                   s11n node trees. It is much faster to read and write
+                   than the text formats because nothing has to be
+                   escaped, quoted or tokenized:
+
+                   - Property values are written as length-prefixed
+                   raw bytes, so arbitrary binary data can be stored
+                   as-is.
+
+                   - Blobs (see s11n::blob), e.g. image data from
+                   S11nQt's QByteArray proxy, are written as raw
+                   bytes, with no base64 step at all. What is a blob
+                   is up to the node, not guessed from the data.
+
+                   - Node names, class names and property keys are
+                   interned in a name table which is built up as the
+                   stream is written, so each is stored in full only
+                   once per file.
+
+                   Layout of each node, after the cookie line:
+
+                   name, class name, property count, (key, value)...,
+                   blob count, (name, crc32c, bytes)..., child count,
+                   children...
+
+                   Blobs (see s11n::blob) are written as raw bytes, and
+                   their checksums are checked on load.
+
+                   The format is not human-readable, so it is not a
+                   good choice for data passed around as text (e.g.
+                   via the system clipboard).
+
+		   Registered aliases: "binary" and the magic cookie.
+                */
+                template <typename NodeType>
+                class binary_serializer : public data_node_serializer<NodeType>
+                {
+                public:
+                        typedef NodeType node_type;
+
+                        typedef binary_serializer<node_type> this_type; // convenience typedef
+			typedef data_node_serializer<node_type> parent_type; // convenience typedef
+
+                        binary_serializer()
+                        {
+                                this->magic_cookie( MAGIC_COOKIE_BINARY );
+                        }
+
+                        virtual ~binary_serializer() {}
+
+                        /**
+                           Writes src out to dest.
+                        */
+                        virtual bool serialize( const node_type & src, std::ostream & dest )
+                        {
+				dest << this->magic_cookie() << '\n';
+				binary::name_table_writer names;
+				this->write_node( src, dest, names );
+				dest.flush();
+				return dest.good();
+                        }
+
+                        /**
+                           Reimplemented to open destfile in binary mode
+                           when this copy of s11n is built without
+                           zfstream support (plain text-mode streams
+                           would translate newline bytes on some
+                           platforms).
+                        */
+                        virtual bool serialize( const node_type & src, const std::string & destfile )
+                        {
+#if s11n_CONFIG_HAVE_ZFSTREAM
+				return this->parent_type::serialize( src, destfile );
+#else
+				if( destfile.empty() ) return false;
+				std::ofstream os( destfile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+				if( ! os.good() ) return false;
+				return this->serialize( src, os );
+#endif
+                        }
+
+                        /**
+                           Parses a node tree from src. Throws an
+                           io_exception if the data are truncated or
+                           corrupt, or an s11n_exception if a blob
+                           fails its checksum.
+                        */
+                        virtual node_type * deserialize( std::istream & src )
+                        {
+				binary::skip_cookie( src, this->magic_cookie() );
+				binary::name_table_reader names;
+				return this->read_node( src, names );
+                        }
+
+                        /**
+                           Counterpart of serialize(node,string).
+                        */
+                        virtual node_type * deserialize( const std::string & src )
+                        {
+#if s11n_CONFIG_HAVE_ZFSTREAM
+				return this->parent_type::deserialize( src );
+#else
+				std::ifstream is( src.c_str(), std::ios::in | std::ios::binary );
+				if( ! is.good() ) return 0;
+				return this->deserialize( is );
+#endif
+                        }
+
+                private:
+                        typedef ::s11n::node_traits<node_type> NT;
+
+                        void write_node( const node_type & src, std::ostream & dest, binary::name_table_writer & names )
+                        {
+				names.write( dest, NT::name(src) );
+				names.write( dest, NT::class_name(src) );
+                                typedef typename NT::property_map_type PMT;
+				PMT const & props( NT::properties(src) );
+				binary::write_uint( dest, props.size() );
+				typename PMT::const_iterator pit = props.begin();
+				typename PMT::const_iterator pet = props.end();
+				for( ; pet != pit; ++pit )
+				{
+					names.write( dest, (*pit).first );
+					binary::write_bytes( dest, (*pit).second );
+				}
+				typedef typename NT::blob_map_type BMT;
+				BMT const & blobs( NT::blobs(src) );
+				binary::write_uint( dest, blobs.size() );
+				typename BMT::const_iterator bit = blobs.begin();
+				typename BMT::const_iterator bet = blobs.end();
+				for( ; bet != bit; ++bit )
+				{
+					names.write( dest, (*bit).first );
+					binary::write_uint( dest, (*bit).second.crc() );
+					binary::write_bytes( dest, (*bit).second.data() );
+				}
+				typedef typename NT::child_list_type CHLT;
+				CHLT const & kids( NT::children(src) );
+				binary::write_uint( dest, kids.size() );
+				typename CHLT::const_iterator cit = kids.begin();
+				typename CHLT::const_iterator cet = kids.end();
+				for( ; cet != cit; ++cit )
+				{
+					this->write_node( **cit, dest, names );
+				}
+                        }
+
+                        node_type * read_node( std::istream & src, binary::name_table_reader & names )
+                        {
+				std::auto_ptr<node_type> n( NT::create() );
+				NT::name( *n, names.read( src ) );
+				NT::class_name( *n, names.read( src ) );
+				unsigned long count = binary::read_uint( src );
+				typename NT::property_map_type & props( NT::properties(*n) );
+				std::string key;
+				for( unsigned long i = 0; i < count; ++i )
+				{
+					key = names.read( src );
+					binary::read_bytes( src, props[key] );
+				}
+				count = binary::read_uint( src );
+				typename NT::blob_map_type & blobs( NT::blobs(*n) );
+				std::string bytes;
+				for( unsigned long i = 0; i < count; ++i )
+				{
+					key = names.read( src );
+					const unsigned long crc = binary::read_uint( src );
+					binary::read_bytes( src, bytes );
+					blobs[key].assign( bytes, crc );
+				}
+				count = binary::read_uint( src );
+				for( unsigned long i = 0; i < count; ++i )
+				{
+					NT::children(*n).push_back( this->read_node( src, names ) );
+				}
+				return n.release();
+                        }
+                };
+
+	} // namespace io
+} // namespace s11n
+
+#undef MAGIC_COOKIE_BINARY
+#endif // s11n_BINARY_SERIALIZER_HPP_INCLUDED
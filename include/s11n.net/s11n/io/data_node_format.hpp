@@ -23,6 +23,7 @@
 #include <s11n.net/s11n/serialize.hpp> // data_node_serializer<> and friends
 
 #include <s11n.net/s11n/traits.hpp>
+#include <s11n.net/s11n/blob.hpp>
 #include <s11n.net/s11n/io/data_node_io.hpp> // default serializer interfaces
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -49,6 +50,29 @@ namespace s11n {
 
                 }
 
+                /**
+                   A scoped lock on the (recursive) mutex which
+                   deserialize_lex_forwarder() holds while it
+                   parses. The flex-based parsers share
+                   process-wide state: the FlexLexer classloader
+                   and each tree_builder_context's lexer map. So
+                   without this, two threads which parse at the
+                   same time (e.g. a loader thread and the GUI
+                   reading the clipboard) would corrupt it.
+
+                   Uses pthreads, or a critical section on
+                   Windows.
+                */
+                class S11N_EXPORT_API parse_lock
+                {
+                public:
+                        parse_lock();
+                        ~parse_lock();
+                private:
+                        parse_lock( const parse_lock & ); // not implemented!
+                        parse_lock & operator=( const parse_lock & ); // not implemented!
+                };
+
                 /**
                    A typedef representing a map of tokens used for
                    "entity translations" by s11n parsers/serializers.
@@ -471,11 +495,22 @@ namespace s11n {
                            Adds the given key/value pair to the
                            current node and returns true. If no node
                            is currently opened it returns false.
+
+                           If val is the text form of a blob (see
+                           s11n::blob::to_text()) it is added to the
+                           node's blobs() instead. That throws an
+                           s11n_exception if the blob is corrupt.
                         */
                         virtual bool add_property( const std::string & key, const std::string & val )
                         {
                                 if( ! this->m_node ) return false;
                                 typedef ::s11n::node_traits<node_type> NTR;
+                                ::s11n::blob b;
+                                if( b.from_text( val ) )
+                                {
+                                        NTR::blobs( *m_node )[key].swap( b );
+                                        return true;
+                                }
                                 NTR::set( *m_node, key, val );
                                 return true;
                         }
@@ -582,6 +617,9 @@ namespace s11n {
 
                    The caller owns the returned poiner, which may be 0.
 
+		   Holds a parse_lock while it runs, so it may be
+		   called from several threads.
+
 		   As of s11n version 1.1.3, this function may throw
 		   on error, and is guaranteed to propagate any
 		   exceptions it catches (after cleaning up). Except
@@ -595,6 +633,7 @@ namespace s11n {
                                                       )
                 {
                         // CERR << "deserialize_lex_forwarder("<<lexerClassName<<")\n";
+                        parse_lock lock;
 			std::auto_ptr<FlexLexer> lexer( ::s11n::cl::classload<FlexLexer>( lexerClassName ) );
                         if( ! lexer.get() )
                         {
@@ -780,6 +819,31 @@ namespace s11n {
 
 
 
+                /**
+                   Calls func( pair ) for each blob of src, where
+                   pair is a NodeType::value_type holding the blob's
+                   name and its text form (see
+                   s11n::blob::to_text()).
+
+                   Text serializers use this to write blobs as
+                   properties, e.g. with a key_value_serializer.
+                   data_node_tree_builder::add_property() turns them
+                   back into blobs.
+                */
+                template <typename NodeType, typename FuncT>
+                void for_each_blob_as_text( const NodeType & src, FuncT func )
+                {
+                        typedef ::s11n::node_traits<NodeType> NTR;
+                        typedef typename NTR::blob_map_type BMT;
+                        typedef typename NodeType::value_type pair_type;
+                        typename BMT::const_iterator it = NTR::blobs( src ).begin();
+                        typename BMT::const_iterator et = NTR::blobs( src ).end();
+                        for( ; et != it; ++it )
+                        {
+                                func( pair_type( (*it).first, (*it).second.to_text() ) );
+                        }
+                }
+
                 /**
                    A helper functor to loop over serializable children
                    of a node from within a Serializer implementation.
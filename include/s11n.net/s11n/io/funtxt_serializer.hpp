@@ -105,15 +105,15 @@ namespace s11n {
                                 std::string key;
 
                                 INDENT(1,0);
+                                key_value_serializer<node_type> kvs( &(this->entity_translations()),
+                                                                     dest,
+                                                                     indent,
+                                                                     " ",
+                                                                     "\n" );
                                 std::for_each(NT::properties(src).begin(),
                                               NT::properties(src).end(),
-                                              key_value_serializer<node_type>(
-                                                                              &(this->entity_translations()),
-                                                                              dest,
-                                                                              indent,
-                                                                              " ",
-                                                                              "\n" )
-                                              );
+                                              kvs );
+                                for_each_blob_as_text( src, kvs );
 
                                 INDENT(1,0);
 
@@ -146,6 +146,18 @@ namespace s11n {
                                         dest << propval;
                                         dest << "</" << key << ">\n";
                                 }
+                                typename NT::blob_map_type::const_iterator bit = NT::blobs(src).begin(),
+                                        bet = NT::blobs(src).end();
+                                for ( ; bet != bit; ++bit )
+                                {
+                                        key = ( *bit ).first;
+                                        propval = ( *bit ).second.to_text();
+                                        strtool::translate_entities( propval, this->entity_translations(), false );
+                                        dest << indent;
+                                        dest << "<" << key << ">";
+                                        dest << propval;
+                                        dest << "</" << key << ">\n";
+                                }
                                 INDENT(1,0);
 
 				typedef typename NT::child_list_type CLT;
@@ -112,7 +112,7 @@ namespace s11n {
                                 std::string key;
 
 
-                                if( cet != cit )
+                                if( (cet != cit) || ! NT::blobs(src).empty() )
                                 { // got properties?
 					dest << indent << "var p = self.$properties = new Array();\n";
 // 					INDENT(2,0);
@@ -131,6 +131,13 @@ namespace s11n {
 // 						if( pos++ < (sz-1) ) { dest << ','; }
 // 						dest << '\n';
                                         }
+					typename NT::blob_map_type::const_iterator bit = NT::blobs(src).begin(),
+						bet = NT::blobs(src).end();
+					for( ; bet != bit; ++bit )
+					{
+						dest << indent << "p["<<quote_js_string((*bit).first) <<"] = "
+						     << quote_js_string( ( *bit ).second.to_text() ) << ";\n";
+					}
 // 					INDENT(1,0);
 // 					dest << indent << "};\n";
                                 }
@@ -112,17 +112,16 @@ namespace s11n {
 
                                 typename NT::property_map_type::const_iterator beg = NT::properties(src).begin(),
                                         end = NT::properties(src).end();
-                                if( end != beg )
+                                if( (end != beg) || ! NT::blobs(src).empty() )
                                 {
                                         //INDENT(1,0);
-                                        std::for_each(beg, end,
-                                                      key_value_serializer<node_type>(
-                                                              &(this->entity_translations()),
-                                                              dest,
-                                                              /* indent + */ ' ' + this->m_open ,
-                                                              " ",
-                                                              this->m_close )
-                                                      );
+                                        key_value_serializer<node_type> kvs( &(this->entity_translations()),
+                                                                             dest,
+                                                                             /* indent + */ ' ' + this->m_open ,
+                                                                             " ",
+                                                                             this->m_close );
+                                        std::for_each( beg, end, kvs );
+                                        for_each_blob_as_text( src, kvs );
                                 }
                                 typename NT::child_list_type::const_iterator chbeg = NT::children(src).begin(),
                                         chend = NT::children(src).end();
@@ -124,11 +124,17 @@ namespace strtool {
            This is useful, for example, for doing XML-entity-to-char
            conversions.
 
-	   Complexity is essentially linear, based on a combination of
-	   buffer.size() and translation_map.size(). Best used with
-	   small maps on short strings! The speed can be increased
-	   signifcantly, but probably only if we restrict keys and
-	   values to 1 character each.
+	   In forward mode only single-character keys can match,
+	   and each character of the input is translated at most
+	   once. Complexity is linear in buffer.size(), and buffer
+	   is not modified at all if nothing needs translating.
+
+	   Reverse mode is also a single left-to-right pass. At
+	   each position the longest matching map value is replaced
+	   by its key, and the replacement is not scanned again, so
+	   e.g. "&amp;lt;" becomes "&lt;", not "<". Complexity is
+	   linear in buffer.size(), times the number of map values
+	   which start with the same character.
 
 	   Design note: this really should be a function template,
 	   accepting any lexically-castable key/val types, but the
@@ -12,6 +12,7 @@
 
 #include <vector>
 #include <s11n.net/s11n/variant.hpp> // for lexical casting
+#include <s11n.net/s11n/blob.hpp>
 #include <s11n.net/s11n/export.hpp>
 
 namespace s11n {
@@ -46,6 +47,12 @@ namespace s11n {
                 */
                 typedef map_type::mapped_type mapped_type;
 
+                /**
+                   The map type this object uses to store blobs
+                   (raw binary data), keyed by name.
+                */
+		typedef std::map < std::string, blob > blob_map_type;
+
                 /**
                    The container type used to store this object's children.
                    It contains (s11n_node *).
@@ -96,6 +103,7 @@ namespace s11n {
 		   - name()
 		   - children()
 		   - properties()
+		   - blobs()
 
 		   Complexity is, in theory, constant time.  For all
 		   data we use their member swap() implementations,
@@ -109,7 +117,7 @@ namespace s11n {
 		void swap( s11n_node & rhs );
 
                 /**
-                   Copies the properties, name, class name and
+                   Copies the properties, blobs, name, class name and
                    children of rhs. If rhs is this object then this
                    function does nothing.
 
@@ -131,6 +139,10 @@ namespace s11n {
                    from the list, or else they will get double-deleted
                    later. In practice it is (almost) never necessary
                    for client code to manipulate this list directly.
+
+                   Since the list may be modified through the returned
+                   reference, this discards the index used by
+                   find_child().
                 */
                 child_list_type & children();
 
@@ -141,8 +153,30 @@ namespace s11n {
 
 
                 /**
-                   Removes all properties and deletes all children from
-                   this object, freeing up their resources.
+                   Returns the first child named n, or 0 if there is
+                   none. This is what s11n::find_child_by_name() uses
+                   for const s11n_nodes.
+
+                   The first lookup on a node with many children
+                   builds a hash index of the children's names, so
+                   that deserializing a wide node with one lookup per
+                   child takes linear instead of quadratic time. The
+                   index is discarded by any non-const call to
+                   children(), clear(), swap() or assignment.
+
+                   Renaming an indexed child (via name() or swap())
+                   discards its parent's index, too.
+
+                   Building the index modifies this object, so
+                   concurrent lookups on the same node from several
+                   threads are not safe.
+                */
+                const s11n_node * find_child( const std::string & n ) const;
+
+                /**
+                   Removes all properties and blobs and deletes all
+                   children from this object, freeing up their
+                   resources.
                    
                    Any pointers to children of this object become
                    invalided by a call to this function (they get
@@ -208,8 +242,8 @@ node.class_name( "foo::FooBar" );
 		std::string name() const;
 
 		/**
-		   Returns true if this object has no properties
-		   and no children. The name() and class_name()
+		   Returns true if this object has no properties, no
+		   blobs and no children. The name() and class_name()
 		   are *not* considered.
 		*/
 		bool empty() const;
@@ -269,11 +303,41 @@ node.class_name( "foo::FooBar" );
 		/** Const overload. */
                 const map_type & properties() const;
 
+		/**
+		   Returns the map of blobs contained by this
+		   node. Blobs hold raw binary data, e.g. images,
+		   which serializers save as efficiently as their
+		   format allows (see s11n::blob).
+
+		   Blob names and property keys are separate
+		   namespaces, but some text formats cannot tell a
+		   property from a blob of the same name, so keep them
+		   distinct.
+		*/
+                blob_map_type & blobs();
+
+		/** Const overload. */
+                const blob_map_type & blobs() const;
+
         private:
 		std::string m_name; // name of this node
 		std::string m_iname; // class_name name of this node
 		map_type m_map; // stores key/value properties.
+		blob_map_type m_blobs; // stores raw binary data
 		child_list_type m_children; // holds child pointers
+		struct child_index;
+		mutable child_index * m_index; // see find_child()
+		/**
+		   The node whose (valid) child index contains this
+		   node, or 0. Lets name() discard that index.
+		*/
+		mutable const s11n_node * m_index_owner;
+
+		/**
+		   Marks the child index as stale and detaches the
+		   children from it.
+		*/
+		void invalidate_index() const;
 
                 /**
                    Copies all properties and child s11n_nodes from
@@ -298,6 +362,14 @@ node.class_name( "foo::FooBar" );
 
 	}; // class s11n_node
 
+	/**
+	   Returns parent.find_child( name ). This overload of
+	   s11n::lookup_child_by_name() lets find_child_by_name() use
+	   s11n_node's child index.
+	*/
+	S11N_EXPORT_API const s11n_node *
+	lookup_child_by_name( const s11n_node & parent, const std::string & name );
+
 } // namespace s11n
 
 #endif // s11n_S11N_NODE_HPP_INCLUDED
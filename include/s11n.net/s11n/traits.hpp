@@ -58,6 +58,12 @@ namespace s11n {
 	*/
 	typedef typename node_type::map_type property_map_type;
 
+	/**
+	   The type used to store blobs (see s11n::blob) for
+	   node_type objects.
+	*/
+	typedef typename node_type::blob_map_type blob_map_type;
+
 
 	/**
 	   The type used to store children of node_type
@@ -147,6 +153,22 @@ namespace s11n {
 	    return node.properties();
 	}
 
+	/**
+	   Returns an immutable reference to the node's map of blobs.
+	*/
+	static const blob_map_type & blobs( const node_type & node )
+	{
+	    return node.blobs();
+	}
+
+	/**
+	   Returns a mutable reference to the node's map of blobs.
+	*/
+	static blob_map_type & blobs( node_type & node )
+	{
+	    return node.blobs();
+	}
+
 	/**
 	   Returns the value of the property with the given
 	   key, or default_value if that property does not
@@ -222,7 +244,7 @@ namespace s11n {
 	}
 
 	/**
-	   Removes all children and properties from node,
+	   Removes all children, properties and blobs from node,
 	   freeing up their resources. Whether the node's
 	   name() and class_name() are cleared is
 	   implementation-defined. In practice, those are
@@ -235,8 +257,8 @@ namespace s11n {
 	}
 
 	/**
-	   Returns true if this object has no properties
-	   and no children. The name() and class_name()
+	   Returns true if this object has no properties,
+	   blobs or children. The name() and class_name()
 	   are *not* considered.
 
 	   Added in version 1.1.3.
@@ -258,6 +280,8 @@ namespace s11n {
 
 	   - properties()
 
+	   - blobs()
+
 	   Added in version 1.1.3.
 	*/
 	static void swap( node_type & lhs, node_type & rhs )
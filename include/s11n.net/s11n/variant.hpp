@@ -8,6 +8,9 @@
 #include <string>
 #include <sstream>
 #include <map>
+#include <limits>
+
+#include <s11n.net/s11n/export.hpp>
 
 /**
    This file houses a little class for lexically casting strings and
@@ -20,6 +23,10 @@
 
 Change history:
 
+QBoard tree:
+- Added non-stream fast paths for the built-in numeric types and
+  bool. Their output is identical to the stream path's.
+
 27 June 2005:
 - Moved operator==() back into class, because they often cause
   odd overload ambiguities in unrelated code when comparing
@@ -90,7 +97,8 @@ namespace s11n { namespace Detail {
 
                 /**
                    Lexically casts str to a value_type, returning
-                   errorVal if the conversion fails.
+                   errorVal if the conversion fails. This is the
+                   generic, stream-based implementation.
 
                    TODO: implement the following suggestion from  
                    Kai Unger <kai.unger@hacon.de> (21 Sept 2004):
@@ -103,7 +111,7 @@ namespace s11n { namespace Detail {
                    of the string is ignored.
                 */
                 template <typename value_type>
-                value_type from_string( const std::string & str, const value_type & errorVal ) throw()
+                value_type stream_from_string( const std::string & str, const value_type & errorVal ) throw()
                 {
                         std::istringstream is( str );
                         if ( !is )
@@ -116,10 +124,11 @@ namespace s11n { namespace Detail {
 
                 /**
                    Returns a string representation of the given
-                   object, which must be ostreamble.
+                   object, which must be ostreamble. This is the
+                   generic, stream-based implementation.
                 */
                 template <typename value_type>
-                std::string to_string( const value_type & obj ) throw()
+                std::string stream_to_string( const value_type & obj ) throw()
                 {
                         std::ostringstream os;
 			os.precision( 16 ); // unfortunate, but for the general case very useful
@@ -127,6 +136,190 @@ namespace s11n { namespace Detail {
                         return os.str();
                 }
 
+                /**
+                   Formats v like (std::ostream << v) does.
+                */
+                S11N_EXPORT_API std::string format_number( long v ) throw();
+
+                /**
+                   Formats v like (std::ostream << v) does.
+                */
+                S11N_EXPORT_API std::string format_number( unsigned long v ) throw();
+
+                /**
+                   Formats v like (std::ostream << v) does with a
+                   precision of 16, as stream_to_string() sets, and
+                   always with '.' as the decimal point.
+                */
+                S11N_EXPORT_API std::string format_number( double v ) throw();
+
+                /**
+                   Parses the leading integer of str like
+                   (std::istream >> integer) does: leading whitespace
+                   is skipped, an optional sign is accepted, and
+                   parsing stops at the first non-digit. On success,
+                   the absolute value goes to magnitude, negative is
+                   set, and true is returned. Returns false if there
+                   are no digits or the value overflows an unsigned
+                   long.
+                */
+                S11N_EXPORT_API bool parse_integer( const std::string & str,
+                                                    unsigned long & magnitude,
+                                                    bool & negative ) throw();
+
+                /**
+                   Parses the leading floating-point number of str
+                   like (std::istream >> double) does in the "C"
+                   locale, independently of the current C locale.
+                   Returns false if no number could be parsed or it
+                   is out of range.
+                */
+                S11N_EXPORT_API bool parse_number( const std::string & str, double & v ) throw();
+
+                /**
+                   lexical_caster implements from_string() and
+                   to_string() for one type. The generic one uses
+                   streams. Specializations for the built-in numeric
+                   types and bool avoid creating streams (and their
+                   locales) and produce the same text.
+                */
+                template <typename value_type>
+                struct lexical_caster
+                {
+                        static value_type from_string( const std::string & str, const value_type & errorVal ) throw()
+                        {
+                                return stream_from_string( str, errorVal );
+                        }
+                        static std::string to_string( const value_type & obj ) throw()
+                        {
+                                return stream_to_string( obj );
+                        }
+                };
+
+#define S11N_VARIANT_SIGNED_CASTER(T)                                   \
+                template <>                                             \
+                struct lexical_caster< T >                              \
+                {                                                       \
+                        static T from_string( const std::string & str, const T & errorVal ) throw() \
+                        {                                               \
+                                unsigned long m = 0;                    \
+                                bool neg = false;                       \
+                                if( ! parse_integer( str, m, neg ) ) return errorVal; \
+                                const unsigned long max = static_cast<unsigned long>( std::numeric_limits< T >::max() ); \
+                                if( neg ? (m > max + 1) : (m > max) ) return errorVal; \
+                                return neg ? static_cast< T >( -static_cast<long>( m - 1 ) - 1 ) : static_cast< T >( m ); \
+                        }                                               \
+                        static std::string to_string( const T & obj ) throw() \
+                        {                                               \
+                                return format_number( static_cast<long>( obj ) ); \
+                        }                                               \
+                };
+                S11N_VARIANT_SIGNED_CASTER(short)
+                S11N_VARIANT_SIGNED_CASTER(int)
+                S11N_VARIANT_SIGNED_CASTER(long)
+#undef S11N_VARIANT_SIGNED_CASTER
+
+#define S11N_VARIANT_UNSIGNED_CASTER(T)                                 \
+                template <>                                             \
+                struct lexical_caster< T >                              \
+                {                                                       \
+                        static T from_string( const std::string & str, const T & errorVal ) throw() \
+                        {                                               \
+                                unsigned long m = 0;                    \
+                                bool neg = false;                       \
+                                if( ! parse_integer( str, m, neg ) ) return errorVal; \
+                                if( m > static_cast<unsigned long>( std::numeric_limits< T >::max() ) ) return errorVal; \
+                                /* like the streams, negative values wrap around */ \
+                                return neg ? static_cast< T >( -static_cast< T >( m ) ) : static_cast< T >( m ); \
+                        }                                               \
+                        static std::string to_string( const T & obj ) throw() \
+                        {                                               \
+                                return format_number( static_cast<unsigned long>( obj ) ); \
+                        }                                               \
+                };
+                S11N_VARIANT_UNSIGNED_CASTER(unsigned short)
+                S11N_VARIANT_UNSIGNED_CASTER(unsigned int)
+                S11N_VARIANT_UNSIGNED_CASTER(unsigned long)
+#undef S11N_VARIANT_UNSIGNED_CASTER
+
+                /**
+                   Streams read and write bools as 0 and 1.
+                */
+                template <>
+                struct lexical_caster<bool>
+                {
+                        static bool from_string( const std::string & str, const bool & errorVal ) throw()
+                        {
+                                unsigned long m = 0;
+                                bool neg = false;
+                                if( ! parse_integer( str, m, neg ) || m > 1 || (neg && m) ) return errorVal;
+                                return 1 == m;
+                        }
+                        static std::string to_string( const bool & obj ) throw()
+                        {
+                                return obj ? "1" : "0";
+                        }
+                };
+
+                template <>
+                struct lexical_caster<double>
+                {
+                        static double from_string( const std::string & str, const double & errorVal ) throw()
+                        {
+                                double d = 0;
+                                return parse_number( str, d ) ? d : errorVal;
+                        }
+                        static std::string to_string( const double & obj ) throw()
+                        {
+                                return format_number( obj );
+                        }
+                };
+
+                /**
+                   Streams print floats as doubles. Parsing rounds the
+                   double to the nearest float, so values such as
+                   "3.4028235e38" become FLT_MAX. Only values which
+                   round to infinity are rejected.
+                */
+                template <>
+                struct lexical_caster<float>
+                {
+                        static float from_string( const std::string & str, const float & errorVal ) throw()
+                        {
+                                double d = 0;
+                                if( ! parse_number( str, d ) ) return errorVal;
+                                const float f = static_cast<float>( d );
+                                const float lim = std::numeric_limits<float>::max();
+                                if( f > lim || f < -lim ) return errorVal;
+                                return f;
+                        }
+                        static std::string to_string( const float & obj ) throw()
+                        {
+                                return format_number( static_cast<double>( obj ) );
+                        }
+                };
+
+                /**
+                   Lexically casts str to a value_type, returning
+                   errorVal if the conversion fails. See
+                   stream_from_string() for the general semantics.
+                */
+                template <typename value_type>
+                value_type from_string( const std::string & str, const value_type & errorVal ) throw()
+                {
+                        return lexical_caster<value_type>::from_string( str, errorVal );
+                }
+
+                /**
+                   Returns a string representation of the given
+                   object, which must be ostreamble.
+                */
+                template <typename value_type>
+                std::string to_string( const value_type & obj ) throw()
+                {
+                        return lexical_caster<value_type>::to_string( obj );
+                }
+
 // Why the hell doesn't overload selection take this one?
 //                  inline std::string to_string( double d ) throw()
 //                  {
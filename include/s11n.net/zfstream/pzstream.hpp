@@ -0,0 +1,240 @@
+#ifndef zfstream_PZSTREAM_HPP_INCLUDED
+#define zfstream_PZSTREAM_HPP_INCLUDED 1
+
+////////////////////////////////////////////////////////////////////////
+// pzstream.hpp
+// Parallel compressing output streams and member-aware decompressing
+// input streams for gzip and bzip2 data.
+// License: Public Domain
+////////////////////////////////////////////////////////////////////////
+#include <iostream>
+#include <fstream>
+#include <cstddef> // size_t
+
+#include <s11n.net/zfstream/zfstream.hpp>
+
+namespace zfstream {
+
+        /**
+           pzstreambuf is an output streambuf which compresses its
+           data on a pool of worker threads, in the style of pigz.
+
+           Output is cut into fixed-size blocks. Each block is
+           compressed independently, as a complete gzip member or
+           bzip2 stream, and the results are written to the sink
+           streambuf in their original order. The concatenation is a
+           standard .gz or .bz2 file: gzip, bzip2, zlib's gzread()
+           and izstream all read it as the concatenation of the
+           blocks.
+
+           Only the thread which writes to this object touches the
+           sink, so the sink needs no locking. The writer only waits
+           on the workers when more than two blocks per worker are
+           in flight, so compression overlaps with producing the
+           output.
+
+           Data which does not fill a block is compressed by close().
+           sync() writes out the blocks which are finished and syncs
+           the sink, but does not cut a short block, since flushing
+           the stream often (e.g. via std::endl) would otherwise
+           ruin the compression ratio.
+
+           Threads are only started once the first block is full,
+           so small outputs are compressed inline. On platforms
+           without pthreads all blocks are compressed inline.
+
+           Policies other than ZLibCompression and BZipCompression
+           (or ones this copy of zfstream was not built with) are
+           an error: the stream will fail on its first write.
+        */
+        class pzstreambuf : public std::streambuf
+        {
+        public:
+                /**
+                   Sets up to write the compressed data to sink,
+                   which must outlive this object.
+
+                   zlevel is the compression level, 1-9, or -1 for
+                   the library default. For bzip2 the level is also
+                   the bzip2 block size, in units of 100kB.
+
+                   threads is the number of worker threads. 0 means
+                   one per online CPU, and 1 means to compress
+                   inline.
+
+                   blockSize is the number of uncompressed bytes
+                   per block. 0 means 128kB for gzip and one bzip2
+                   block (100kB * level) for bzip2.
+                */
+                pzstreambuf( std::streambuf * sink,
+                             CompressionPolicy policy,
+                             int zlevel = -1,
+                             int threads = 0,
+                             std::size_t blockSize = 0 );
+
+                /** Calls close(). */
+                virtual ~pzstreambuf();
+
+                /**
+                   Compresses any remaining data, waits for the
+                   workers, writes everything to the sink and stops
+                   the workers. Returns false if compressing or
+                   writing any block failed. Calling this more than
+                   once is harmless. After this, writing to this
+                   object fails.
+                */
+                bool close();
+
+                /** Returns false once compressing or writing has failed. */
+                bool good() const;
+
+        protected:
+                virtual int overflow( int c = EOF );
+                virtual int sync();
+
+        private:
+                struct impl;
+                impl * m_impl;
+                bool flush_block( bool last );
+                //! Copying not allowed.
+                pzstreambuf( pzstreambuf const & );
+                //! Copying not allowed.
+                pzstreambuf & operator=( pzstreambuf const & );
+        };
+
+        /**
+           An ostream which compresses its output in parallel via
+           pzstreambuf. Used like ogzstream/obzstream:
+
+<pre>
+opzstream os( "mygame.s11n.gz", ZLibCompression );
+os << ...;
+</pre>
+
+           It can also wrap another ostream, e.g. one which writes
+           to a QIODevice:
+
+<pre>
+{
+        opzstream zos( os, ZLibCompression );
+        zos << ...;
+} // destroying zos finishes the compressed data
+os.flush();
+</pre>
+
+           The compressed data are only complete after close() or
+           destruction.
+        */
+        class opzstream : public std::ostream
+        {
+        public:
+                /**
+                   Writes compressed data to the given file. On
+                   error this stream's badbit is set.
+                */
+                opzstream( const char * filename,
+                           CompressionPolicy policy,
+                           int zlevel = -1,
+                           int threads = 0 );
+
+                /**
+                   Writes compressed data to dest, which must
+                   outlive this object. If finishing the compressed
+                   data fails then dest's badbit is set, too.
+                */
+                opzstream( std::ostream & dest,
+                           CompressionPolicy policy,
+                           int zlevel = -1,
+                           int threads = 0 );
+
+                /** Calls close(). */
+                virtual ~opzstream();
+
+                /**
+                   Finishes the compressed data (see
+                   pzstreambuf::close()) and closes the file, if
+                   any. Sets badbit on error.
+                */
+                void close();
+
+                pzstreambuf * rdbuf() { return m_buf; }
+
+        private:
+                std::filebuf * m_file;
+                std::ostream * m_dest;
+                pzstreambuf * m_buf;
+                //! Copying not allowed.
+                opzstream( opzstream const & );
+                //! Copying not allowed.
+                opzstream & operator=( opzstream const & );
+        };
+
+        /**
+           izstreambuf is an input streambuf which decompresses
+           gzip or bzip2 data read from another streambuf. The
+           format is detected from the first bytes, and data in
+           neither format is passed through unchanged.
+
+           Unlike ibzstream, it reads all of the members of a file
+           made of concatenated compressed streams, as written by
+           pzstreambuf, pbzip2 or "cat a.gz b.gz". As gzip does, it
+           ignores junk following a complete gzip member.
+        */
+        class izstreambuf : public std::streambuf
+        {
+        public:
+                /** src must outlive this object. */
+                explicit izstreambuf( std::streambuf * src );
+                virtual ~izstreambuf();
+
+                /**
+                   Returns the detected format: ZLibCompression,
+                   BZipCompression, or NoCompression for data passed
+                   through as-is.
+                */
+                CompressionPolicy compression() const;
+
+        protected:
+                virtual int_type underflow();
+
+        private:
+                struct impl;
+                impl * m_impl;
+                //! Copying not allowed.
+                izstreambuf( izstreambuf const & );
+                //! Copying not allowed.
+                izstreambuf & operator=( izstreambuf const & );
+        };
+
+        /**
+           An istream which reads data through an izstreambuf,
+           from either a file or another istream.
+        */
+        class izstream : public std::istream
+        {
+        public:
+                /**
+                   Reads from the given file. If it cannot be opened
+                   then this stream's failbit is set.
+                */
+                explicit izstream( const char * filename );
+
+                /** Reads from src, which must outlive this object. */
+                explicit izstream( std::istream & src );
+
+                virtual ~izstream();
+
+                izstreambuf * rdbuf() { return m_buf; }
+
+        private:
+                std::filebuf * m_file;
+                izstreambuf * m_buf;
+                //! Copying not allowed.
+                izstream( izstream const & );
+                //! Copying not allowed.
+                izstream & operator=( izstream const & );
+        };
+
+} // namespace zfstream
+
+#endif // zfstream_PZSTREAM_HPP_INCLUDED
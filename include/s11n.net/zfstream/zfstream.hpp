@@ -122,6 +122,44 @@ namespace zfstream {
         */
         std::ostream * get_ostream( const std::string & filename );
 
+        /**
+           Sets the number of threads used to compress output
+           opened via get_ostream(). 0 (the default) means one per
+           online CPU, in which case output is compressed in
+           parallel by a zfstream::opzstream. 1 means to use the
+           single-threaded ogzstream/obzstream.
+        */
+        void compression_threads( int n );
+
+        /**
+           Returns the value set via compression_threads().
+        */
+        int compression_threads();
+
+        /**
+           If compression_policy() calls for compression and this
+           copy of zfstream supports it, returns a new
+           zfstream::opzstream which compresses its output and
+           writes it to dest, else returns 0, in which case the
+           caller should write to dest directly.
+
+           The compressed data are finished when the returned
+           stream is deleted, which the caller must do before
+           closing dest. If finishing fails, dest's badbit is set.
+        */
+        std::ostream * get_ostream( std::ostream & dest );
+
+        /**
+           If this copy of zfstream supports decompression, returns
+           a new zfstream::izstream which reads from src and
+           decompresses it if it is compressed (in any supported
+           format, regardless of compression_policy()). Otherwise
+           it returns 0, in which case the caller should read from
+           src directly. The caller owns the returned object, which
+           must not outlive src.
+        */
+        std::istream * get_istream( std::istream & src );
+
 } // namespace zfstream
 
 #endif // zfstream_FILE_UTIL_H_INCLUDED
@@ -0,0 +1,158 @@
+#include <s11n.net/s11n/s11n_node.hpp>
+#include <s11n.net/s11n/io/serializers.hpp>
+#include <s11n.net/s11n/io/binary_serializer.hpp>
+
+
+namespace s11n { namespace io { namespace binary {
+
+	void write_uint( std::ostream & dest, unsigned long v )
+	{
+		char buf[16];
+		int len = 0;
+		do
+		{
+			unsigned char b = static_cast<unsigned char>( v & 0x7f );
+			v >>= 7;
+			if( v ) b |= 0x80;
+			buf[len++] = static_cast<char>( b );
+		} while( v );
+		dest.rdbuf()->sputn( buf, len );
+	}
+
+	unsigned long read_uint( std::istream & src )
+	{
+		std::streambuf * sb = src.rdbuf();
+		unsigned long v = 0;
+		for( unsigned int shift = 0; shift < (sizeof(unsigned long) * 8); shift += 7 )
+		{
+			const int ch = sb->sbumpc();
+			if( std::char_traits<char>::eof() == ch )
+			{
+				src.setstate( std::ios::eofbit | std::ios::failbit );
+				throw ::s11n::io_exception( "binary_serializer: unexpected end of input." );
+			}
+			v |= static_cast<unsigned long>( ch & 0x7f ) << shift;
+			if( ! (ch & 0x80) ) return v;
+		}
+		throw ::s11n::io_exception( "binary_serializer: corrupt integer in input." );
+		return 0;
+	}
+
+	void write_bytes( std::ostream & dest, std::string const & s )
+	{
+		write_uint( dest, s.size() );
+		if( ! s.empty() )
+		{
+			dest.rdbuf()->sputn( s.data(), static_cast<std::streamsize>( s.size() ) );
+		}
+	}
+
+	/**
+	   Reads len raw bytes from src into dest. Throws an
+	   io_exception on a short read.
+	*/
+	static void read_raw( std::istream & src, unsigned long len, std::string & dest )
+	{
+		dest.clear();
+		if( ! len ) return;
+		std::streambuf * sb = src.rdbuf();
+		/**
+		   Values of up to a chunk are read in one go. Longer ones
+		   are read a chunk at a time, so that a corrupt length
+		   runs into EOF instead of into a huge allocation.
+		*/
+		static const unsigned long chunk = 1024 * 1024;
+		unsigned long got = 0;
+		while( got < len )
+		{
+			const unsigned long want = ((len - got) > chunk) ? chunk : (len - got);
+			dest.resize( got + want );
+			const std::streamsize n = sb->sgetn( &dest[got], static_cast<std::streamsize>( want ) );
+			if( n != static_cast<std::streamsize>( want ) )
+			{
+				src.setstate( std::ios::eofbit | std::ios::failbit );
+				throw ::s11n::io_exception( "binary_serializer: unexpected end of input (wanted %lu bytes, got %lu).",
+							    len, got + static_cast<unsigned long>( n > 0 ? n : 0 ) );
+			}
+			got += want;
+		}
+	}
+
+	void read_bytes( std::istream & src, std::string & dest )
+	{
+		read_raw( src, read_uint( src ), dest );
+	}
+
+	void skip_cookie( std::istream & src, std::string const & cookie )
+	{
+		std::streambuf * sb = src.rdbuf();
+		if( '#' != sb->sgetc() ) return; // already consumed. The first data byte is never '#'.
+		std::string line;
+		int ch;
+		while( (std::char_traits<char>::eof() != (ch = sb->sbumpc())) && ('\n' != ch) )
+		{
+			line += static_cast<char>( ch );
+		}
+		if( line != cookie )
+		{
+			throw ::s11n::io_exception( "binary_serializer: expected cookie [%s] but got [%s].",
+						    cookie.c_str(), line.c_str() );
+		}
+	}
+
+	name_table_writer::name_table_writer() : m_ids()
+	{
+	}
+
+	void name_table_writer::write( std::ostream & dest, std::string const & name )
+	{
+		map_type::iterator it = m_ids.find( name );
+		if( m_ids.end() != it )
+		{
+			write_uint( dest, (*it).second + 1 );
+			return;
+		}
+		const unsigned long id = static_cast<unsigned long>( m_ids.size() );
+		m_ids.insert( it, map_type::value_type( name, id ) );
+		write_uint( dest, 0 );
+		write_bytes( dest, name );
+	}
+
+	name_table_reader::name_table_reader() : m_names()
+	{
+	}
+
+	std::string const & name_table_reader::read( std::istream & src )
+	{
+		const unsigned long ref = read_uint( src );
+		if( 0 == ref )
+		{
+			m_names.push_back( std::string() );
+			read_bytes( src, m_names.back() );
+			return m_names.back();
+		}
+		if( ref > m_names.size() )
+		{
+			throw ::s11n::io_exception( "binary_serializer: name reference %lu is out of range (table size=%lu).",
+						    ref, static_cast<unsigned long>( m_names.size() ) );
+		}
+		return m_names[ref-1];
+	}
+
+}}} // namespace s11n::io::binary
+
+namespace {
+
+        void binary_serializer_registration_init()
+        {
+
+#define SERINST(NodeT)                                  \
+                ::s11n::io::register_serializer< ::s11n::io::binary_serializer< NodeT > >( "s11n::io::binary_serializer", "binary" );
+                SERINST(s11n::s11n_node);
+#undef SERINST
+        }
+
+        int binary_reg_placeholder = 
+                ( binary_serializer_registration_init(), 1 );
+
+} // anonymous namespace
@@ -0,0 +1,289 @@
+#include <s11n.net/s11n/blob.hpp>
+#include <s11n.net/s11n/exception.hpp>
+
+#include <algorithm> // swap()
+#include <cstdio> // sprintf()
+#include <cstdlib> // strtoul()
+
+#if defined(__SSE4_2__)
+#  include <nmmintrin.h>
+#  define S11N_CRC32C_HW 1
+#else
+#  define S11N_CRC32C_HW 0
+#endif
+
+namespace s11n {
+
+	namespace {
+#if ! S11N_CRC32C_HW
+		/**
+		   Slice-by-8 tables for the reflected CRC-32C
+		   polynomial. They are built during static
+		   initialization, before any threads exist.
+		*/
+		struct crc32c_tables
+		{
+			unsigned long t[8][256];
+			crc32c_tables()
+			{
+				const unsigned long poly = 0x82F63B78UL;
+				for( unsigned int i = 0; i < 256; ++i )
+				{
+					unsigned long c = i;
+					for( int k = 0; k < 8; ++k )
+					{
+						c = (c & 1) ? (poly ^ (c >> 1)) : (c >> 1);
+					}
+					t[0][i] = c;
+				}
+				for( unsigned int i = 0; i < 256; ++i )
+				{
+					for( int s = 1; s < 8; ++s )
+					{
+						t[s][i] = (t[s-1][i] >> 8) ^ t[0][t[s-1][i] & 0xff];
+					}
+				}
+			}
+		};
+		const crc32c_tables crc_tables;
+#endif
+	}
+
+	unsigned long crc32c( void const * data, std::size_t n, unsigned long crc )
+	{
+		unsigned char const * p = static_cast<unsigned char const *>( data );
+		unsigned long c = (crc ^ 0xFFFFFFFFUL) & 0xFFFFFFFFUL;
+#if S11N_CRC32C_HW
+		for( ; n && (reinterpret_cast<std::size_t>( p ) & 7); --n )
+		{
+			c = _mm_crc32_u8( static_cast<unsigned int>( c ), *p++ );
+		}
+#  if defined(__x86_64__) || defined(_M_X64)
+		unsigned long long c64 = c;
+		for( ; n >= 8; n -= 8, p += 8 )
+		{
+			c64 = _mm_crc32_u64( c64, *reinterpret_cast<unsigned long long const *>( p ) );
+		}
+		c = static_cast<unsigned long>( c64 );
+#  endif
+		for( ; n >= 4; n -= 4, p += 4 )
+		{
+			c = _mm_crc32_u32( static_cast<unsigned int>( c ), *reinterpret_cast<unsigned int const *>( p ) );
+		}
+		for( ; n; --n )
+		{
+			c = _mm_crc32_u8( static_cast<unsigned int>( c ), *p++ );
+		}
+#else
+		unsigned long const (*t)[256] = crc_tables.t;
+		for( ; n >= 8; n -= 8, p += 8 )
+		{
+			// Byte-wise loads, so this works on any alignment
+			// and byte order.
+			const unsigned long lo = c ^ ( p[0] | (p[1] << 8) | (p[2] << 16)
+						       | (static_cast<unsigned long>( p[3] ) << 24) );
+			c = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff]
+				^ t[5][(lo >> 16) & 0xff] ^ t[4][(lo >> 24) & 0xff]
+				^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+		}
+		for( ; n; --n )
+		{
+			c = t[0][(c ^ *p++) & 0xff] ^ (c >> 8);
+		}
+#endif
+		return (c ^ 0xFFFFFFFFUL) & 0xFFFFFFFFUL;
+	}
+
+	static char const base64_chars[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	/** Returns the 6-bit value of base64 digit c, or -1. */
+	static int base64_digit( unsigned char c )
+	{
+		if( (c >= 'A') && (c <= 'Z') ) return c - 'A';
+		if( (c >= 'a') && (c <= 'z') ) return c - 'a' + 26;
+		if( (c >= '0') && (c <= '9') ) return c - '0' + 52;
+		if( '+' == c ) return 62;
+		if( '/' == c ) return 63;
+		return -1;
+	}
+
+	void base64_encode( void const * data, std::size_t n, std::string & dest )
+	{
+		unsigned char const * p = static_cast<unsigned char const *>( data );
+		dest.clear();
+		dest.reserve( ((n + 2) / 3) * 4 );
+		std::size_t i = 0;
+		for( ; (i + 3) <= n; i += 3 )
+		{
+			const unsigned long acc = (p[i] << 16) | (p[i+1] << 8) | p[i+2];
+			dest += base64_chars[(acc >> 18) & 0x3f];
+			dest += base64_chars[(acc >> 12) & 0x3f];
+			dest += base64_chars[(acc >> 6) & 0x3f];
+			dest += base64_chars[acc & 0x3f];
+		}
+		if( (n - i) == 2 )
+		{
+			const unsigned long acc = (p[i] << 16) | (p[i+1] << 8);
+			dest += base64_chars[(acc >> 18) & 0x3f];
+			dest += base64_chars[(acc >> 12) & 0x3f];
+			dest += base64_chars[(acc >> 6) & 0x3f];
+			dest += '=';
+		}
+		else if( (n - i) == 1 )
+		{
+			const unsigned long acc = (p[i] << 16);
+			dest += base64_chars[(acc >> 18) & 0x3f];
+			dest += base64_chars[(acc >> 12) & 0x3f];
+			dest += "==";
+		}
+	}
+
+	bool base64_decode( char const * in, std::size_t len, std::string & dest )
+	{
+		dest.clear();
+		if( len % 4 ) return false;
+		if( ! len ) return true;
+		const std::size_t pad =
+			('=' == in[len-1]) ? (('=' == in[len-2]) ? 2 : 1) : 0;
+		const std::size_t digits = len - pad;
+		dest.reserve( (len / 4) * 3 );
+		unsigned long acc = 0;
+		int d = 0;
+		for( std::size_t i = 0; i < digits; ++i )
+		{
+			if( (d = base64_digit( static_cast<unsigned char>( in[i] ) )) < 0 ) return false;
+			acc = (acc << 6) | static_cast<unsigned long>( d );
+			if( 3 == (i % 4) )
+			{
+				dest += static_cast<char>( (acc >> 16) & 0xff );
+				dest += static_cast<char>( (acc >> 8) & 0xff );
+				dest += static_cast<char>( acc & 0xff );
+				acc = 0;
+			}
+		}
+		// A padded tail must not have stray low bits, or encoding
+		// the bytes again would not give back the same text.
+		if( 2 == pad )
+		{
+			if( acc & 0x0f ) return false;
+			dest += static_cast<char>( (acc >> 4) & 0xff );
+		}
+		else if( 1 == pad )
+		{
+			if( acc & 0x03 ) return false;
+			dest += static_cast<char>( (acc >> 10) & 0xff );
+			dest += static_cast<char>( (acc >> 2) & 0xff );
+		}
+		return true;
+	}
+
+	blob::blob() : m_data(), m_crc(0)
+	{
+	}
+
+	blob::blob( void const * data, std::size_t n ) : m_data(), m_crc(0)
+	{
+		this->assign( data, n );
+	}
+
+	void blob::assign( void const * data, std::size_t n )
+	{
+		this->m_data.assign( static_cast<char const *>( data ), n );
+		this->m_crc = crc32c( data, n );
+	}
+
+	void blob::assign( std::string & data, unsigned long crc )
+	{
+		const unsigned long got = crc32c( data.data(), data.size() );
+		if( got != crc )
+		{
+			throw s11n_exception( "Blob failed its checksum: expected %08lx, got %08lx.", crc, got );
+		}
+		this->m_data.swap( data );
+		data.clear();
+		this->m_crc = crc;
+	}
+
+	std::string const & blob::data() const
+	{
+		return this->m_data;
+	}
+
+	std::size_t blob::size() const
+	{
+		return this->m_data.size();
+	}
+
+	bool blob::empty() const
+	{
+		return this->m_data.empty();
+	}
+
+	unsigned long blob::crc() const
+	{
+		return this->m_crc;
+	}
+
+	void blob::swap( blob & rhs )
+	{
+		this->m_data.swap( rhs.m_data );
+		std::swap( this->m_crc, rhs.m_crc );
+	}
+
+	bool blob::operator==( blob const & rhs ) const
+	{
+		return (this->m_crc == rhs.m_crc) && (this->m_data == rhs.m_data);
+	}
+
+	bool blob::operator!=( blob const & rhs ) const
+	{
+		return ! (*this == rhs);
+	}
+
+	std::string const & blob::prefix()
+	{
+		static const std::string pre( "s11n:blob:crc32c=" );
+		return pre;
+	}
+
+	std::string blob::to_text() const
+	{
+		char crc[16];
+		std::sprintf( crc, "%08lx:", this->m_crc );
+		std::string b64;
+		base64_encode( this->m_data.data(), this->m_data.size(), b64 );
+		std::string ret;
+		ret.reserve( prefix().size() + 9 + b64.size() );
+		ret += prefix();
+		ret += crc;
+		ret += b64;
+		return ret;
+	}
+
+	bool blob::from_text( std::string const & text )
+	{
+		std::string const & pre( prefix() );
+		if( 0 != text.compare( 0, pre.size(), pre ) ) return false;
+		const std::string::size_type at = pre.size();
+		if( (text.size() < (at + 9)) || (':' != text[at + 8]) )
+		{
+			throw s11n_exception( "Blob text has no checksum." );
+		}
+		char const * hex = text.c_str() + at;
+		char * end = 0;
+		const unsigned long crc = std::strtoul( hex, &end, 16 );
+		if( end != (hex + 8) )
+		{
+			throw s11n_exception( "Blob text has a malformed checksum." );
+		}
+		std::string raw;
+		if( ! base64_decode( text.data() + at + 9, text.size() - at - 9, raw ) )
+		{
+			throw s11n_exception( "Blob text is not valid base64." );
+		}
+		this->assign( raw, crc );
+		return true;
+	}
+
+} // namespace s11n
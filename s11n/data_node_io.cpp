@@ -10,8 +10,15 @@
 #endif
 
 #include <s11n.net/s11n/io/data_node_io.hpp>
+#include <s11n.net/s11n/io/data_node_format.hpp> // parse_lock
 #include <s11n.net/s11n/io/FlexLexer.hpp>
 
+#if defined(WIN32)
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#endif
+
 namespace s11n {
         namespace io {
 
@@ -62,6 +69,46 @@ namespace s11n {
                         }
                 }
 
+                namespace {
+                        /**
+                           The mutex behind parse_lock. It is set up
+                           during static initialization, before any
+                           threads which might parse exist.
+                        */
+                        struct parse_mutex
+                        {
+#if defined(WIN32)
+                                CRITICAL_SECTION cs;
+                                parse_mutex() { ::InitializeCriticalSection( &cs ); }
+                                void lock() { ::EnterCriticalSection( &cs ); }
+                                void unlock() { ::LeaveCriticalSection( &cs ); }
+#else
+                                pthread_mutex_t mx;
+                                parse_mutex()
+                                {
+                                        pthread_mutexattr_t attr;
+                                        ::pthread_mutexattr_init( &attr );
+                                        ::pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_RECURSIVE );
+                                        ::pthread_mutex_init( &mx, &attr );
+                                        ::pthread_mutexattr_destroy( &attr );
+                                }
+                                void lock() { ::pthread_mutex_lock( &mx ); }
+                                void unlock() { ::pthread_mutex_unlock( &mx ); }
+#endif
+                        };
+                        parse_mutex the_parse_mutex;
+                }
+
+                parse_lock::parse_lock()
+                {
+                        the_parse_mutex.lock();
+                }
+
+                parse_lock::~parse_lock()
+                {
+                        the_parse_mutex.unlock();
+                }
+
                 std::string get_magic_cookie( const std::string & src, bool AsFile )
                 {
                         if( src.empty() ) return src;
@@ -0,0 +1,650 @@
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstring> // memcpy
+
+#include <s11n.net/zfstream/zfstream_config.hpp> // expected: HAVE_ZLIB, HAVE_BZLIB
+#include <s11n.net/zfstream/pzstream.hpp>
+
+#if HAVE_ZLIB
+#  include <zlib.h>
+#endif
+#if HAVE_BZLIB
+#  include <bzlib.h>
+#endif
+
+#if defined(WIN32)
+#  define ZFSTREAM_PZ_THREADS 0
+#else
+#  define ZFSTREAM_PZ_THREADS 1
+#  include <pthread.h>
+#  include <unistd.h> // sysconf()
+#endif
+
+namespace zfstream {
+
+        namespace {
+                /**
+                   Compresses in as one complete gzip member or
+                   bzip2 stream and stores the result in out.
+                */
+                bool compress_block( CompressionPolicy policy, int level,
+                                     std::string const & in, std::string & out )
+                {
+#if HAVE_ZLIB
+                        if( ZLibCompression == policy )
+                        {
+                                z_stream zs;
+                                std::memset( &zs, 0, sizeof(zs) );
+                                // windowBits 15+16 == deflate with a gzip wrapper
+                                if( Z_OK != deflateInit2( &zs, (level < 0) ? Z_DEFAULT_COMPRESSION : level,
+                                                          Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY ) )
+                                {
+                                        return false;
+                                }
+                                out.resize( deflateBound( &zs, in.size() ) + 32 );
+                                zs.next_in = reinterpret_cast<Bytef *>( const_cast<char *>( in.data() ) );
+                                zs.avail_in = in.size();
+                                zs.next_out = reinterpret_cast<Bytef *>( &out[0] );
+                                zs.avail_out = out.size();
+                                const int rc = deflate( &zs, Z_FINISH );
+                                out.resize( zs.total_out );
+                                deflateEnd( &zs );
+                                return Z_STREAM_END == rc;
+                        }
+#endif
+#if HAVE_BZLIB
+                        if( BZipCompression == policy )
+                        {
+                                // The bzip2 docs promise that 1% + 600 bytes is always enough.
+                                unsigned int len = in.size() + in.size() / 100 + 600;
+                                out.resize( len );
+                                const int rc = BZ2_bzBuffToBuffCompress( &out[0], &len,
+                                                                         const_cast<char *>( in.data() ), in.size(),
+                                                                         (level < 1) ? 9 : level, 0, 0 );
+                                out.resize( (BZ_OK == rc) ? len : 0 );
+                                return BZ_OK == rc;
+                        }
+#endif
+                        return false;
+                }
+
+                bool policy_supported( CompressionPolicy policy )
+                {
+#if HAVE_ZLIB
+                        if( ZLibCompression == policy ) return true;
+#endif
+#if HAVE_BZLIB
+                        if( BZipCompression == policy ) return true;
+#endif
+                        return false;
+                }
+
+                /** One block of output, from filling to writing. */
+                struct pz_job
+                {
+                        std::string in;
+                        std::string out;
+                        bool done;
+                        bool ok;
+                        pz_job() : in(), out(), done(false), ok(false) {}
+                };
+
+                int default_thread_count()
+                {
+#if ZFSTREAM_PZ_THREADS
+                        const long n = sysconf( _SC_NPROCESSORS_ONLN );
+                        return (n < 1) ? 1 : ((n > 32) ? 32 : int(n));
+#else
+                        return 1;
+#endif
+                }
+        }
+
+        struct pzstreambuf::impl
+        {
+                std::streambuf * sink;
+                CompressionPolicy policy;
+                int level;
+                std::size_t blockSize;
+                int threads;
+                /** The block being filled. Its in member is the put area. */
+                pz_job * fill;
+                /** Blocks in the order they must be written. */
+                std::deque<pz_job *> pending;
+                /** Blocks waiting for a worker. */
+                std::deque<pz_job *> queue;
+                /** Written blocks, kept for reuse. */
+                std::vector<pz_job *> spare;
+                std::size_t submitted;
+                bool failed;
+                bool closed;
+#if ZFSTREAM_PZ_THREADS
+                std::vector<pthread_t> workers;
+                pthread_mutex_t lock;
+                pthread_cond_t workCV;
+                pthread_cond_t doneCV;
+                bool stopping;
+#endif
+
+                impl( std::streambuf * s, CompressionPolicy p, int lv, int th, std::size_t bs )
+                        : sink(s), policy(p), level(lv), blockSize(bs), threads(th),
+                          fill(0), pending(), queue(), spare(),
+                          submitted(0), failed(false), closed(false)
+#if ZFSTREAM_PZ_THREADS
+                        , workers(), stopping(false)
+#endif
+                {
+                        if( level > 9 ) level = 9;
+                        if( 0 == threads ) threads = default_thread_count();
+                        else if( threads < 1 ) threads = 1;
+                        if( 0 == blockSize )
+                        {
+                                blockSize = (BZipCompression == policy)
+                                        ? 100000 * ((level < 1) ? 9 : level)
+                                        : 128 * 1024;
+                        }
+#if ZFSTREAM_PZ_THREADS
+                        pthread_mutex_init( &lock, 0 );
+                        pthread_cond_init( &workCV, 0 );
+                        pthread_cond_init( &doneCV, 0 );
+#else
+                        threads = 1;
+#endif
+                        // Fail early on policies we can't handle.
+                        failed = ! policy_supported( policy );
+                }
+
+                ~impl()
+                {
+                        delete fill;
+                        for( std::size_t i = 0; i < pending.size(); ++i ) delete pending[i];
+                        for( std::size_t i = 0; i < spare.size(); ++i ) delete spare[i];
+#if ZFSTREAM_PZ_THREADS
+                        pthread_cond_destroy( &doneCV );
+                        pthread_cond_destroy( &workCV );
+                        pthread_mutex_destroy( &lock );
+#endif
+                }
+
+                pz_job * new_job()
+                {
+                        pz_job * j = 0;
+                        if( spare.empty() ) j = new pz_job;
+                        else
+                        {
+                                j = spare.back();
+                                spare.pop_back();
+                        }
+                        j->in.resize( blockSize );
+                        j->done = j->ok = false;
+                        return j;
+                }
+
+#if ZFSTREAM_PZ_THREADS
+                static void * work( void * arg )
+                {
+                        impl * self = static_cast<impl *>( arg );
+                        pthread_mutex_lock( &self->lock );
+                        for( ;; )
+                        {
+                                while( self->queue.empty() && ! self->stopping )
+                                {
+                                        pthread_cond_wait( &self->workCV, &self->lock );
+                                }
+                                if( self->queue.empty() ) break;
+                                pz_job * j = self->queue.front();
+                                self->queue.pop_front();
+                                pthread_mutex_unlock( &self->lock );
+                                const bool ok = compress_block( self->policy, self->level, j->in, j->out );
+                                pthread_mutex_lock( &self->lock );
+                                j->ok = ok;
+                                j->done = true;
+                                pthread_cond_broadcast( &self->doneCV );
+                        }
+                        pthread_mutex_unlock( &self->lock );
+                        return 0;
+                }
+
+                void start_workers()
+                {
+                        for( int i = 0; i < threads; ++i )
+                        {
+                                pthread_t t;
+                                if( 0 != pthread_create( &t, 0, &impl::work, this ) ) break;
+                                workers.push_back( t );
+                        }
+                        // If no thread could be started we just carry on inline.
+                }
+
+                void stop_workers()
+                {
+                        pthread_mutex_lock( &lock );
+                        stopping = true;
+                        pthread_cond_broadcast( &workCV );
+                        pthread_mutex_unlock( &lock );
+                        for( std::size_t i = 0; i < workers.size(); ++i )
+                        {
+                                pthread_join( workers[i], 0 );
+                        }
+                        workers.clear();
+                }
+#endif
+
+                /**
+                   Writes finished blocks, in order, until no more
+                   than maxPending blocks are left in flight. Waits
+                   for the workers if needed. Returns false on error.
+                */
+                bool drain( std::size_t maxPending )
+                {
+                        for( ;; )
+                        {
+#if ZFSTREAM_PZ_THREADS
+                                pthread_mutex_lock( &lock );
+                                while( ! pending.empty() && ! pending.front()->done
+                                       && pending.size() > maxPending )
+                                {
+                                        pthread_cond_wait( &doneCV, &lock );
+                                }
+                                pz_job * j = (pending.empty() || ! pending.front()->done)
+                                        ? 0 : pending.front();
+                                if( j ) pending.pop_front();
+                                pthread_mutex_unlock( &lock );
+#else
+                                pz_job * j = 0;
+                                if( ! pending.empty() )
+                                {
+                                        j = pending.front();
+                                        pending.pop_front();
+                                }
+#endif
+                                if( ! j ) return ! failed;
+                                if( ! j->ok ) failed = true;
+                                else if( ! failed )
+                                {
+                                        const std::streamsize n = j->out.size();
+                                        if( n != sink->sputn( j->out.data(), n ) ) failed = true;
+                                }
+                                spare.push_back( j );
+                        }
+                }
+
+                /** Hands j over for compression. */
+                bool submit( pz_job * j, bool last )
+                {
+                        ++submitted;
+#if ZFSTREAM_PZ_THREADS
+                        if( workers.empty() && threads > 1 && ! last ) this->start_workers();
+                        if( ! workers.empty() )
+                        {
+                                pthread_mutex_lock( &lock );
+                                pending.push_back( j );
+                                queue.push_back( j );
+                                pthread_cond_signal( &workCV );
+                                pthread_mutex_unlock( &lock );
+                                return this->drain( 2 * workers.size() );
+                        }
+#endif
+                        j->ok = compress_block( policy, level, j->in, j->out );
+                        j->done = true;
+                        pending.push_back( j );
+                        return this->drain( 0 );
+                }
+        };
+
+        pzstreambuf::pzstreambuf( std::streambuf * sink,
+                                  CompressionPolicy policy,
+                                  int zlevel,
+                                  int threads,
+                                  std::size_t blockSize )
+                : m_impl( new impl( sink, policy, zlevel, threads, blockSize ) )
+        {
+                m_impl->fill = m_impl->new_job();
+                char * b = &m_impl->fill->in[0];
+                this->setp( b, b + m_impl->fill->in.size() );
+        }
+
+        pzstreambuf::~pzstreambuf()
+        {
+                this->close();
+                delete m_impl;
+        }
+
+        bool pzstreambuf::good() const
+        {
+                return ! m_impl->failed;
+        }
+
+        bool pzstreambuf::flush_block( bool last )
+        {
+                pz_job * j = m_impl->fill;
+                const std::size_t used = this->pptr() - this->pbase();
+                if( ! used && ! (last && ! m_impl->submitted) )
+                {
+                        // Nothing to do, except that we always emit at
+                        // least one member so that an empty stream is
+                        // still a valid compressed file.
+                        return ! m_impl->failed;
+                }
+                m_impl->fill = 0;
+                this->setp( 0, 0 );
+                j->in.resize( used );
+                const bool ok = m_impl->submit( j, last );
+                if( ! last )
+                {
+                        m_impl->fill = m_impl->new_job();
+                        char * b = &m_impl->fill->in[0];
+                        this->setp( b, b + m_impl->fill->in.size() );
+                }
+                return ok;
+        }
+
+        int pzstreambuf::overflow( int c )
+        {
+                if( m_impl->closed || m_impl->failed ) return EOF;
+                if( ! this->flush_block( false ) ) return EOF;
+                if( traits_type::eq_int_type( c, traits_type::eof() ) ) return traits_type::not_eof( c );
+                *this->pptr() = traits_type::to_char_type( c );
+                this->pbump( 1 );
+                return c;
+        }
+
+        int pzstreambuf::sync()
+        {
+                if( m_impl->closed ) return m_impl->failed ? -1 : 0;
+                if( ! m_impl->drain( m_impl->pending.size() ) ) return -1;
+                return (-1 == m_impl->sink->pubsync()) ? -1 : 0;
+        }
+
+        bool pzstreambuf::close()
+        {
+                if( m_impl->closed ) return ! m_impl->failed;
+                if( ! m_impl->failed ) this->flush_block( true );
+                else this->setp( 0, 0 );
+                m_impl->closed = true;
+                m_impl->drain( 0 );
+#if ZFSTREAM_PZ_THREADS
+                m_impl->stop_workers();
+#endif
+                if( -1 == m_impl->sink->pubsync() ) m_impl->failed = true;
+                return ! m_impl->failed;
+        }
+
+
+        opzstream::opzstream( const char * filename,
+                              CompressionPolicy policy,
+                              int zlevel,
+                              int threads )
+                : std::ostream( 0 ), m_file( new std::filebuf ), m_dest( 0 ), m_buf( 0 )
+        {
+                const bool opened = 0 != m_file->open( filename, std::ios::out | std::ios::binary );
+                m_buf = new pzstreambuf( m_file, policy, zlevel, threads );
+                this->init( m_buf );
+                if( ! opened || ! m_buf->good() ) this->setstate( std::ios::badbit );
+        }
+
+        opzstream::opzstream( std::ostream & dest,
+                              CompressionPolicy policy,
+                              int zlevel,
+                              int threads )
+                : std::ostream( 0 ), m_file( 0 ), m_dest( &dest ), m_buf( 0 )
+        {
+                m_buf = new pzstreambuf( dest.rdbuf(), policy, zlevel, threads );
+                this->init( m_buf );
+                if( ! dest.rdbuf() || ! m_buf->good() ) this->setstate( std::ios::badbit );
+        }
+
+        opzstream::~opzstream()
+        {
+                this->close();
+                delete m_buf;
+                delete m_file;
+        }
+
+        void opzstream::close()
+        {
+                bool ok = m_buf->close();
+                if( m_file && m_file->is_open() && ! m_file->close() ) ok = false;
+                if( ! ok )
+                {
+                        this->setstate( std::ios::badbit );
+                        if( m_dest ) m_dest->setstate( std::ios::badbit );
+                }
+        }
+
+
+        struct izstreambuf::impl
+        {
+                std::streambuf * src;
+                CompressionPolicy kind;
+                std::vector<char> inbuf;
+                std::vector<char> outbuf;
+                /** Input bytes in inbuf not yet consumed: [inPos,inEnd). */
+                std::size_t inPos;
+                std::size_t inEnd;
+                /** Members/streams finished so far. */
+                std::size_t members;
+                bool streamOpen;
+                bool atEnd;
+#if HAVE_ZLIB
+                z_stream zs;
+#endif
+#if HAVE_BZLIB
+                bz_stream bs;
+#endif
+                explicit impl( std::streambuf * s )
+                        : src(s), kind(NoCompression),
+                          inbuf( 64 * 1024 ), outbuf( 64 * 1024 ),
+                          inPos(0), inEnd(0), members(0),
+                          streamOpen(false), atEnd(false)
+                {
+#if HAVE_ZLIB
+                        std::memset( &zs, 0, sizeof(zs) );
+#endif
+#if HAVE_BZLIB
+                        std::memset( &bs, 0, sizeof(bs) );
+#endif
+                        // Peek at the magic bytes. They stay in inbuf
+                        // as the start of the input.
+                        while( src && inEnd < 3 )
+                        {
+                                const std::streamsize n = src->sgetn( &inbuf[inEnd], 3 - inEnd );
+                                if( n < 1 ) break;
+                                inEnd += n;
+                        }
+                        const unsigned char * m = reinterpret_cast<unsigned char *>( &inbuf[0] );
+#if HAVE_ZLIB
+                        if( inEnd >= 2 && 0x1f == m[0] && 0x8b == m[1] ) kind = ZLibCompression;
+#endif
+#if HAVE_BZLIB
+                        if( inEnd >= 3 && 'B' == m[0] && 'Z' == m[1] && 'h' == m[2] ) kind = BZipCompression;
+#endif
+                        (void)m;
+                }
+
+                ~impl()
+                {
+                        this->end_stream();
+                }
+
+                void end_stream()
+                {
+                        if( ! streamOpen ) return;
+                        streamOpen = false;
+#if HAVE_ZLIB
+                        if( ZLibCompression == kind ) inflateEnd( &zs );
+#endif
+#if HAVE_BZLIB
+                        if( BZipCompression == kind ) BZ2_bzDecompressEnd( &bs );
+#endif
+                }
+
+                bool begin_stream()
+                {
+#if HAVE_ZLIB
+                        if( ZLibCompression == kind )
+                        {
+                                std::memset( &zs, 0, sizeof(zs) );
+                                streamOpen = (Z_OK == inflateInit2( &zs, 15 + 16 ));
+                        }
+#endif
+#if HAVE_BZLIB
+                        if( BZipCompression == kind )
+                        {
+                                std::memset( &bs, 0, sizeof(bs) );
+                                streamOpen = (BZ_OK == BZ2_bzDecompressInit( &bs, 0, 0 ));
+                        }
+#endif
+                        return streamOpen;
+                }
+
+                /** Refills inbuf if it is empty. Returns false at EOF. */
+                bool fill_input()
+                {
+                        if( inPos < inEnd ) return true;
+                        inPos = inEnd = 0;
+                        const std::streamsize n = src->sgetn( &inbuf[0], inbuf.size() );
+                        if( n < 1 ) return false;
+                        inEnd = n;
+                        return true;
+                }
+
+                /**
+                   Decompresses some data into outbuf and returns
+                   how many bytes were produced. 0 means EOF or
+                   error.
+                */
+                std::size_t decompress()
+                {
+                        while( ! atEnd )
+                        {
+                                if( ! this->fill_input() )
+                                {
+                                        // A member cut short is an error, which
+                                        // for our purposes is just EOF.
+                                        atEnd = true;
+                                        break;
+                                }
+                                if( ! streamOpen && ! this->begin_stream() )
+                                {
+                                        atEnd = true;
+                                        break;
+                                }
+                                std::size_t produced = 0;
+                                bool finished = false;
+                                bool error = false;
+#if HAVE_ZLIB
+                                if( ZLibCompression == kind )
+                                {
+                                        zs.next_in = reinterpret_cast<Bytef *>( &inbuf[inPos] );
+                                        zs.avail_in = inEnd - inPos;
+                                        zs.next_out = reinterpret_cast<Bytef *>( &outbuf[0] );
+                                        zs.avail_out = outbuf.size();
+                                        const int rc = inflate( &zs, Z_NO_FLUSH );
+                                        inPos = inEnd - zs.avail_in;
+                                        produced = outbuf.size() - zs.avail_out;
+                                        finished = (Z_STREAM_END == rc);
+                                        error = ! finished && (Z_OK != rc) && (Z_BUF_ERROR != rc);
+                                }
+#endif
+#if HAVE_BZLIB
+                                if( BZipCompression == kind )
+                                {
+                                        bs.next_in = &inbuf[inPos];
+                                        bs.avail_in = inEnd - inPos;
+                                        bs.next_out = &outbuf[0];
+                                        bs.avail_out = outbuf.size();
+                                        const int rc = BZ2_bzDecompress( &bs );
+                                        inPos = inEnd - bs.avail_in;
+                                        produced = outbuf.size() - bs.avail_out;
+                                        finished = (BZ_STREAM_END == rc);
+                                        error = ! finished && (BZ_OK != rc);
+                                }
+#endif
+                                if( finished )
+                                {
+                                        // Another member may follow.
+                                        this->end_stream();
+                                        ++members;
+                                }
+                                else if( error )
+                                {
+                                        // Corrupt data, or junk after the last
+                                        // member, which gzip ignores, too.
+                                        this->end_stream();
+                                        atEnd = true;
+                                }
+                                if( produced ) return produced;
+                        }
+                        return 0;
+                }
+        };
+
+        izstreambuf::izstreambuf( std::streambuf * src )
+                : m_impl( new impl( src ) )
+        {
+                this->setg( 0, 0, 0 );
+        }
+
+        izstreambuf::~izstreambuf()
+        {
+                delete m_impl;
+        }
+
+        CompressionPolicy izstreambuf::compression() const
+        {
+                return m_impl->kind;
+        }
+
+        izstreambuf::int_type izstreambuf::underflow()
+        {
+                if( this->gptr() < this->egptr() ) return traits_type::to_int_type( *this->gptr() );
+                char * b = 0;
+                std::size_t n = 0;
+                if( NoCompression == m_impl->kind )
+                {
+                        if( m_impl->src && m_impl->fill_input() )
+                        {
+                                b = &m_impl->inbuf[m_impl->inPos];
+                                n = m_impl->inEnd - m_impl->inPos;
+                                m_impl->inPos = m_impl->inEnd;
+                        }
+                }
+                else
+                {
+                        n = m_impl->decompress();
+                        b = &m_impl->outbuf[0];
+                }
+                if( ! n )
+                {
+                        this->setg( 0, 0, 0 );
+                        return traits_type::eof();
+                }
+                this->setg( b, b, b + n );
+                return traits_type::to_int_type( *b );
+        }
+
+
+        izstream::izstream( const char * filename )
+                : std::istream( 0 ), m_file( new std::filebuf ), m_buf( 0 )
+        {
+                const bool opened = 0 != m_file->open( filename, std::ios::in | std::ios::binary );
+                m_buf = new izstreambuf( opened ? m_file : 0 );
+                this->init( m_buf );
+                if( ! opened ) this->setstate( std::ios::failbit );
+        }
+
+        izstream::izstream( std::istream & src )
+                : std::istream( 0 ), m_file( 0 ), m_buf( new izstreambuf( src.rdbuf() ) )
+        {
+                this->init( m_buf );
+        }
+
+        izstream::~izstream()
+        {
+                delete m_buf;
+                delete m_file;
+        }
+
+} // namespace zfstream
@@ -18,16 +18,29 @@ namespace s11n {
 
 	using namespace ::s11n::debug;
 
-	s11n_node::s11n_node( const std::string & name ) : m_name(name),m_iname(NODE_CLASS_NAME)
+	/**
+	   An open-addressing hash table of child positions, keyed
+	   by the children's names. Only the first of several
+	   children with the same name is entered.
+	*/
+	struct s11n_node::child_index
+	{
+		std::vector<long> slots; // positions in m_children, or -1
+		std::size_t mask;
+		bool valid;
+		child_index() : slots(), mask(0), valid(false) {}
+	};
+
+	s11n_node::s11n_node( const std::string & name ) : m_name(name),m_iname(NODE_CLASS_NAME),m_index(0),m_index_owner(0)
 	{
 		S11N_TRACE(TRACE_CTOR) << "creating s11n_node("<<name<<") @ " << std::hex << this << '\n';
 	}
-	s11n_node::s11n_node( const std::string & name, const std::string implclass ) : m_name( name ), m_iname( implclass )
+	s11n_node::s11n_node( const std::string & name, const std::string implclass ) : m_name( name ), m_iname( implclass ), m_index(0), m_index_owner(0)
 	{
 		S11N_TRACE(TRACE_CTOR) << "creating s11n_node("<<name<<","<<implclass<<") @ " << std::hex << this << '\n';
 	}
 
-	s11n_node::s11n_node() : m_name("s11n_node"), m_iname(NODE_CLASS_NAME)
+	s11n_node::s11n_node() : m_name("s11n_node"), m_iname(NODE_CLASS_NAME), m_index(0), m_index_owner(0)
 	{
 		S11N_TRACE(TRACE_CTOR) << "creating s11n_node() @ " << std::hex << this << '\n';
 	}
@@ -38,7 +51,7 @@ namespace s11n {
                 this->copy( rhs );
                 return *this;
         }
-        s11n_node::s11n_node( const s11n_node & rhs )
+        s11n_node::s11n_node( const s11n_node & rhs ) : m_index(0), m_index_owner(0)
         {
                 if( &rhs == this ) return;
                 this->copy( rhs );
@@ -47,6 +60,7 @@ namespace s11n {
 	{
 		S11N_TRACE(TRACE_DTOR) << "~s11n_node @ " << std::hex << this << '\n';
                 this->clear_children();
+		delete this->m_index;
 	}
 
         s11n_node::map_type & s11n_node::properties()
@@ -59,11 +73,27 @@ namespace s11n {
                 return this->m_map;
         }
 
+        s11n_node::blob_map_type & s11n_node::blobs()
+        {
+                return this->m_blobs;
+        }
+
+        const s11n_node::blob_map_type & s11n_node::blobs() const
+        {
+                return this->m_blobs;
+        }
+
 
 	void s11n_node::swap( s11n_node & rhs )
 	{
+		this->invalidate_index();
+		rhs.invalidate_index();
+		// The names change, too:
+		if( this->m_index_owner ) this->m_index_owner->invalidate_index();
+		if( rhs.m_index_owner ) rhs.m_index_owner->invalidate_index();
 		this->children().swap( rhs.children() );
 		this->properties().swap( rhs.properties() );
+		this->m_blobs.swap( rhs.m_blobs );
 		this->m_name.swap( rhs.m_name );
 		this->m_iname.swap( rhs.m_iname );
 	}
@@ -78,6 +108,7 @@ namespace s11n {
                 std::copy( rhs.properties().begin(), rhs.properties().end(),
                            std::insert_iterator<map_type>( this->m_map, this->m_map.begin() )
                            );
+                this->m_blobs = rhs.m_blobs;
                 std::for_each( rhs.children().begin(),
                                rhs.children().end(),
                                Detail::child_pointer_deep_copier<child_list_type>( this->children() )
@@ -86,6 +117,7 @@ namespace s11n {
 
 	s11n_node::child_list_type & s11n_node::children()
 	{
+		this->invalidate_index();
                 return this->m_children;
 	}
 
@@ -94,10 +126,90 @@ namespace s11n {
                 return this->m_children;
 	}
 
+	namespace {
+		/**
+		   Nodes with fewer children than this are searched
+		   linearly: for them it is faster than hashing.
+		*/
+		const std::size_t ChildIndexThreshold = 16;
+
+		/** FNV-1a */
+		inline std::size_t hash_child_name( const std::string & n )
+		{
+			std::size_t h = 2166136261U;
+			for( std::string::size_type i = 0; i < n.size(); ++i )
+			{
+				h = (h ^ static_cast<unsigned char>( n[i] )) * 16777619U;
+			}
+			return h;
+		}
+	}
+
+	void s11n_node::invalidate_index() const
+	{
+		if( ! this->m_index || ! this->m_index->valid ) return;
+		this->m_index->valid = false;
+		const child_list_type & kids( this->m_children );
+		for( child_list_type::const_iterator it = kids.begin(); kids.end() != it; ++it )
+		{
+			if( *it && ((*it)->m_index_owner == this) ) (*it)->m_index_owner = 0;
+		}
+	}
+
+	const s11n_node * s11n_node::find_child( const std::string & n ) const
+	{
+		const child_list_type & kids( this->m_children );
+		if( kids.size() < ChildIndexThreshold || n.empty() )
+		{
+			// same semantics as Detail::same_name
+			for( child_list_type::const_iterator it = kids.begin(); kids.end() != it; ++it )
+			{
+				if( *it ? ((*it)->m_name == n) : n.empty() ) return *it;
+			}
+			return 0;
+		}
+		if( ! this->m_index ) this->m_index = new child_index;
+		child_index & idx( *this->m_index );
+		if( ! idx.valid )
+		{
+			std::size_t sz = 32;
+			while( sz < kids.size() * 2 ) sz *= 2;
+			idx.slots.assign( sz, -1 );
+			idx.mask = sz - 1;
+			for( std::size_t i = 0; i < kids.size(); ++i )
+			{
+				if( ! kids[i] ) continue;
+				kids[i]->m_index_owner = this;
+				const std::string & kn( kids[i]->m_name );
+				std::size_t h = hash_child_name( kn ) & idx.mask;
+				for( ; -1 != idx.slots[h]; h = (h + 1) & idx.mask )
+				{
+					if( kids[idx.slots[h]]->m_name == kn ) break;
+				}
+				if( -1 == idx.slots[h] ) idx.slots[h] = long(i);
+			}
+			idx.valid = true;
+		}
+		for( std::size_t h = hash_child_name( n ) & idx.mask;
+		     -1 != idx.slots[h];
+		     h = (h + 1) & idx.mask )
+		{
+			const s11n_node * ch = kids[idx.slots[h]];
+			if( ch->m_name == n ) return ch;
+		}
+		return 0;
+	}
+
+	const s11n_node * lookup_child_by_name( const s11n_node & parent, const std::string & name )
+	{
+		return parent.find_child( name );
+	}
+
 	void s11n_node::clear()
 	{
                 this->clear_children();
 		this->clear_properties();
+		this->m_blobs.clear();
 	}
 
 	void s11n_node::class_name( const std::string & n )
@@ -115,12 +227,14 @@ namespace s11n {
 	bool s11n_node::empty() const
 	{
 		return this->children().empty()
-			&& this->properties().empty();
+			&& this->properties().empty()
+			&& this->m_blobs.empty();
 	}
 
 	void
         s11n_node::name( const std::string & n )
 	{
+		if( this->m_index_owner ) this->m_index_owner->invalidate_index();
 		this->m_name = n;
 	}
 
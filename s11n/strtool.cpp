@@ -1,6 +1,7 @@
 #include <s11n.net/s11n/io/strtool.hpp>
 #include <cctype>
 #include <algorithm>
+#include <vector>
 
 namespace s11n { namespace io { namespace strtool {
 
@@ -8,62 +9,93 @@ namespace s11n { namespace io { namespace strtool {
         {
                 if( str.empty() || ( 0 == map.size() ) ) return 0;
                 std::size_t count = 0;
-                std::string::size_type pos = str.npos;
-                std::string::size_type pos2 = str.npos;
-                entity_map::const_iterator mit;
+                entity_map::const_iterator mit = map.begin();
                 entity_map::const_iterator met = map.end();
-                std::string key;
-                std::string val;
                 if( reverse )
                 {
-			// CERR << "Reverse-translating entities.\n";
-			// treat KEY=VAL as VAL=KEY
-                        mit = map.begin();
+			// treat KEY=VAL as VAL=KEY. This is a single
+			// left-to-right pass: at each position the longest
+			// matching VAL is replaced, and its replacement is
+			// not looked at again. Candidates are bucketed by
+			// their first char.
+			typedef std::vector<entity_map::const_iterator> CandList;
+			CandList cands[256];
+			bool any = false;
                         for( ; mit != met; ++mit )
                         {
-                                key = (*mit).second;
-                                val = (*mit).first;
-				//CERR << "reverse-map key=["<<key<<"] val=["<<val<<"]\n";
-                                while( str.npos != (pos = str.rfind( key, pos2 )) )
-                                {
-                                        ++count;
-					pos2 = pos-1;
-                                        str.replace( pos, key.size(), val );
-                                }
-				pos2 = str.size() - 1;
+				if( (*mit).second.empty() ) continue;
+				cands[static_cast<unsigned char>( (*mit).second[0] )].push_back( mit );
+				any = true;
                         }
+			if( ! any ) return 0;
+			const std::string::size_type sz = str.size();
+			std::string out;
+			std::string::size_type run = 0;
+			for( std::string::size_type pos = 0; pos < sz; )
+			{
+				const CandList & cl = cands[static_cast<unsigned char>( str[pos] )];
+				entity_map::const_iterator best = met;
+				std::string::size_type bestLen = 0;
+				for( CandList::const_iterator cit = cl.begin(); cl.end() != cit; ++cit )
+				{
+					const std::string & v = (**cit).second;
+					if( v.size() > bestLen
+					    && 0 == str.compare( pos, v.size(), v ) )
+					{
+						best = *cit;
+						bestLen = v.size();
+					}
+				}
+				if( met == best )
+				{
+					++pos;
+					continue;
+				}
+				if( 0 == count ) out.reserve( sz );
+				++count;
+				out.append( str, run, pos - run );
+				out += (*best).first;
+				pos += bestLen;
+				run = pos;
+			}
+			if( 0 == count ) return 0;
+			out.append( str, run, str.npos );
+			str.swap( out );
                 }
                 else
                 {
-			//CERR << "Translating entities in ["<<str<<"]...\n";
-			// treat KEY=VAL as KEY=VAL
-// broken code: causes an endless loop in some cases
-//                         mit = map.begin();
-// 			pos = 0;
-// 			pos2 = str.size()-1;
-//                         for( ; mit != met; ++mit )
-//                         {
-//                                 key = (*mit).first;
-//                                 val = (*mit).second;
-//  				//CERR << "forward-map key=["<<key<<"] val=["<<val<<"]\n";
-//                                 while( str.npos != (pos = str.rfind( key, pos2 )) )
-//                                 {
-// 					// CERR << "forward-map key=["<<key<<"] val=["<<val<<"]\n";
-//                                         ++count;
-// 					pos2 = pos-1;
-//                                         str.replace( pos, key.size(), val );
-//                                 }
-// 				pos2 = str.size()-1;
-//                         }
-// this code works:
-                         pos = str.size() - 1;
-                         for( ; pos != std::string::npos; --pos )
-                         {
-                                 mit = map.find( str.substr(pos,1) );
-                                 if( met == mit ) continue;
-                                 ++count;
-                                 str.replace( pos, 1, (*mit).second );
-                         }
+			// treat KEY=VAL as KEY=VAL. Only single-char keys
+			// can match. Look them up in a table indexed by
+			// char, and leave the string alone if nothing needs
+			// translating, which is the common case.
+			const std::string * table[256] = { 0 };
+			bool any = false;
+			for( ; mit != met; ++mit )
+			{
+				if( 1 != (*mit).first.size() ) continue;
+				table[static_cast<unsigned char>( (*mit).first[0] )] = &(*mit).second;
+				any = true;
+			}
+			if( ! any ) return 0;
+			const char * const begin = str.data();
+			const char * const end = begin + str.size();
+			const char * p = begin;
+			while( p != end && ! table[static_cast<unsigned char>( *p )] ) ++p;
+			if( p == end ) return 0;
+			std::string out;
+			out.reserve( str.size() + str.size() / 8 + 16 );
+			const char * run = begin;
+			for( ; p != end; ++p )
+			{
+				const std::string * rep = table[static_cast<unsigned char>( *p )];
+				if( ! rep ) continue;
+				++count;
+				out.append( run, p );
+				out += *rep;
+				run = p + 1;
+			}
+			out.append( run, end );
+			str.swap( out );
                 }
                 return count;
         }
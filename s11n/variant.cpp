@@ -0,0 +1,166 @@
+#include <cstdio> // sprintf
+#include <cstdlib> // strtod
+#include <cstring> // strchr
+#include <cerrno>
+#include <cmath> // HUGE_VAL
+#include <clocale> // localeconv
+
+#include <s11n.net/s11n/variant.hpp>
+
+namespace s11n { namespace Detail { namespace Private {
+
+	namespace {
+		/**
+		   The C library's decimal point for the current C
+		   locale. Streams always use the classic locale's '.',
+		   but the application (e.g. any QApplication) may have
+		   called setlocale().
+		*/
+		inline char c_decimal_point()
+		{
+			const char * dp = std::localeconv()->decimal_point;
+			return (dp && *dp) ? *dp : '.';
+		}
+
+		/**
+		   Same as isspace() in the "C" locale, which is what
+		   the classic stream locale skips.
+		*/
+		inline bool is_c_space( char c )
+		{
+			return ' ' == c || ('\t' <= c && c <= '\r');
+		}
+
+		/**
+		   Writes the decimal digits of v backwards, ending
+		   just before end, and returns a pointer to the first
+		   digit.
+		*/
+		inline char * format_digits( unsigned long v, char * end )
+		{
+			char * p = end;
+			do
+			{
+				*--p = char( '0' + (v % 10) );
+				v /= 10;
+			} while( v );
+			return p;
+		}
+	}
+
+	std::string format_number( unsigned long v ) throw()
+	{
+		char buf[32];
+		char * end = buf + sizeof(buf);
+		return std::string( format_digits( v, end ), end );
+	}
+
+	std::string format_number( long v ) throw()
+	{
+		char buf[32];
+		char * end = buf + sizeof(buf);
+		if( v >= 0 ) return std::string( format_digits( static_cast<unsigned long>( v ), end ), end );
+		// -(v+1)+1 avoids overflowing on LONG_MIN
+		char * p = format_digits( static_cast<unsigned long>( -(v + 1) ) + 1, end );
+		*--p = '-';
+		return std::string( p, end );
+	}
+
+	std::string format_number( double v ) throw()
+	{
+		char buf[40];
+		const int len = std::sprintf( buf, "%.16g", v );
+		if( len <= 0 ) return stream_to_string( v );
+		const char dp = c_decimal_point();
+		if( '.' != dp )
+		{
+			char * p = std::strchr( buf, dp );
+			if( p ) *p = '.';
+		}
+		return std::string( buf, buf + len );
+	}
+
+	bool parse_integer( const std::string & str,
+			    unsigned long & magnitude,
+			    bool & negative ) throw()
+	{
+		std::string::const_iterator it = str.begin();
+		const std::string::const_iterator et = str.end();
+		while( et != it && is_c_space( *it ) ) ++it;
+		negative = false;
+		if( et != it && ('-' == *it || '+' == *it) )
+		{
+			negative = ('-' == *it);
+			++it;
+		}
+		if( et == it || *it < '0' || *it > '9' ) return false;
+		const unsigned long max = static_cast<unsigned long>( -1 );
+		unsigned long m = 0;
+		for( ; et != it && '0' <= *it && *it <= '9'; ++it )
+		{
+			const unsigned long d = static_cast<unsigned long>( *it - '0' );
+			if( m > (max - d) / 10 ) return false;
+			m = m * 10 + d;
+		}
+		magnitude = m;
+		return true;
+	}
+
+	bool parse_number( const std::string & str, double & v ) throw()
+	{
+		// Copy the part which looks like a number, in the
+		// syntax the streams accept, into a buffer, then let
+		// strtod() do the (correctly rounded) conversion.
+		char buf[128];
+		std::size_t n = 0;
+		std::string::const_iterator it = str.begin();
+		const std::string::const_iterator et = str.end();
+		while( et != it && is_c_space( *it ) ) ++it;
+		if( et != it && ('-' == *it || '+' == *it) ) buf[n++] = *it++;
+		bool digits = false;
+		for( ; et != it && '0' <= *it && *it <= '9'; ++it )
+		{
+			if( n >= sizeof(buf) - 8 ) return false;
+			buf[n++] = *it;
+			digits = true;
+		}
+		const char dp = c_decimal_point();
+		if( et != it && '.' == *it )
+		{
+			buf[n++] = dp;
+			++it;
+			for( ; et != it && '0' <= *it && *it <= '9'; ++it )
+			{
+				if( n >= sizeof(buf) - 8 ) return false;
+				buf[n++] = *it;
+				digits = true;
+			}
+		}
+		if( ! digits ) return false;
+		if( et != it && ('e' == *it || 'E' == *it) )
+		{
+			std::string::const_iterator exp = it + 1;
+			std::size_t en = n;
+			buf[en++] = 'e';
+			if( et != exp && ('-' == *exp || '+' == *exp) ) buf[en++] = *exp++;
+			bool edigits = false;
+			for( ; et != exp && '0' <= *exp && *exp <= '9' && en < sizeof(buf) - 1; ++exp )
+			{
+				buf[en++] = *exp;
+				edigits = true;
+			}
+			if( ! edigits ) return false; // the streams fail on "1e" too
+			n = en;
+		}
+		buf[n] = 0;
+		errno = 0;
+		char * end = 0;
+		const double d = std::strtod( buf, &end );
+		if( end == buf ) return false;
+		// Like the streams, reject overflow but accept underflow.
+		if( ERANGE == errno && (d == HUGE_VAL || d == -HUGE_VAL) ) return false;
+		v = d;
+		return true;
+	}
+
+}}} // namespace s11n::Detail::Private
@@ -17,6 +17,12 @@
 #if HAVE_BZLIB
 #  include <s11n.net/zfstream/bzstream.hpp>
 #endif
+#if HAVE_ZLIB || HAVE_BZLIB
+#  define ZFSTREAM_HAVE_PZSTREAM 1
+#  include <s11n.net/zfstream/pzstream.hpp>
+#else
+#  define ZFSTREAM_HAVE_PZSTREAM 0
+#endif
 
 namespace zfstream {
 
@@ -35,7 +41,7 @@ namespace zfstream {
 
         bool supports_compression_policy( CompressionPolicy c )
         {
-                CompressionPolicy p = compression_policy();
+                CompressionPolicy p = c;
                 if( NoCompression == p ) return true;
 #if HAVE_BZLIB
                 if( BZipCompression == p ) return true;
@@ -59,6 +65,16 @@ namespace zfstream {
                 return m_comp_policy;
         }
 
+        static int m_comp_threads = 0;
+        void compression_threads( int n )
+        {
+                m_comp_threads = (n < 0) ? 0 : n;
+        }
+        int compression_threads()
+        {
+                return m_comp_threads;
+        }
+
 
         std::istream * get_istream( const std::string & src, bool AsFile )
         {
@@ -92,7 +108,9 @@ namespace zfstream {
                 if( 'B' == buff[0] && 'Z' == buff[1] )
                 {
                         //COUT << "bzip!"<<std::endl;
-                        return new zfstream::ibzstream( src.c_str() );
+                        // ibzstream stops after the first of several
+                        // concatenated streams, as written by opzstream.
+                        return new zfstream::izstream( src.c_str() );
                 }
 #endif                
 #if HAVE_ZLIB
@@ -116,15 +134,48 @@ namespace zfstream {
                   // case GZipCompression:
                   // REMINDER: when/if GZip/ZLib mean different things, this will break!
                   // C++ won't let me put both in here when they have the same value.
-                  case ZLibCompression: return new zfstream::ogzstream( fname.c_str() );
+                  case ZLibCompression:
+                          if( 1 != compression_threads() )
+                          {
+                                  return new zfstream::opzstream( fname.c_str(), ZLibCompression, -1, compression_threads() );
+                          }
+                          return new zfstream::ogzstream( fname.c_str() );
 #endif
 #if HAVE_BZLIB
-                  case BZipCompression: return new zfstream::obzstream( fname.c_str() );
+                  case BZipCompression:
+                          if( 1 != compression_threads() )
+                          {
+                                  return new zfstream::opzstream( fname.c_str(), BZipCompression, -1, compression_threads() );
+                          }
+                          return new zfstream::obzstream( fname.c_str() );
 #endif
                   default:
                           return new std::ofstream( fname.c_str() );
                 }
         }
 
+        std::ostream * get_ostream( std::ostream & dest )
+        {
+#if ZFSTREAM_HAVE_PZSTREAM
+                const CompressionPolicy p = compression_policy();
+                if( NoCompression != p && supports_compression_policy( p ) )
+                {
+                        return new zfstream::opzstream( dest, p, -1, compression_threads() );
+                }
+#endif
+                (void)dest;
+                return 0;
+        }
+
+        std::istream * get_istream( std::istream & src )
+        {
+#if ZFSTREAM_HAVE_PZSTREAM
+                return new zfstream::izstream( src );
+#else
+                (void)src;
+                return 0;
+#endif
+        }
+
 
 } // namespace zfstream
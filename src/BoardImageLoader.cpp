@@ -0,0 +1,133 @@
+/*
+ * This file is (or was, at some point) part of the QBoard project
+ * (http://code.google.com/p/qboard)
+ *
+ * Copyright (c) 2008 Stephan Beal (http://wanderinghorse.net/home/stephan/)
+ *
+ * This file may be used under the terms of the GNU General Public
+ * License versions 2.0 or 3.0 as published by the Free Software
+ * Foundation and appearing in the files LICENSE.GPL2 and LICENSE.GPL3
+ * included in the packaging of this file.
+ *
+ */
+
+#include <QAtomicInt>
+#include <QDebug>
+#include <QImageIOHandler>
+#include <QImageReader>
+
+#include <qboard/BoardImageLoader.h>
+
+struct BoardImageLoader::Impl
+{
+    QString fileName;
+    QAtomicInt cancelled;
+    Impl( QString const & fn ) :
+	fileName(fn),
+	cancelled(0)
+    {
+    }
+    ~Impl()
+    {
+    }
+};
+
+BoardImageLoader::BoardImageLoader( QString const & fn ) :
+    QThread(),
+    impl(new Impl(fn))
+{
+    connect( this, SIGNAL(finished()), this, SLOT(deleteLater()) );
+}
+
+BoardImageLoader::~BoardImageLoader()
+{
+    this->cancel();
+    this->wait();
+    delete impl;
+}
+
+QString BoardImageLoader::fileName() const
+{
+    return impl->fileName;
+}
+
+void BoardImageLoader::cancel()
+{
+    impl->cancelled = 1;
+}
+
+bool BoardImageLoader::cancelled() const
+{
+    return 0 != impl->cancelled;
+}
+
+QSize BoardImageLoader::imageSize( QString const & fn )
+{
+    QImageReader rd( fn );
+    return rd.canRead() ? rd.size() : QSize();
+}
+
+void BoardImageLoader::run()
+{
+    /**
+       Reminder: we decode the full image in one go and slice it up
+       here, instead of reading each chunk with
+       QImageReader::setClipRect(). Most handlers (e.g. PNG) don't
+       support clip rects natively and would decode the whole file
+       once per chunk, and those which do (e.g. JPEG) still have to
+       decode everything above the clip rect.
+    */
+    QImageReader rd( impl->fileName );
+    const QSize full( rd.size() );
+    QSize psz( full );
+    const bool wantPreview = full.isValid()
+	&& ((full.width() > PreviewSize) || (full.height() > PreviewSize));
+    if( wantPreview )
+    {
+	psz.scale( PreviewSize, PreviewSize, Qt::KeepAspectRatio );
+    }
+    /**
+       Only formats which can decode at a reduced size (e.g. JPEG)
+       get a separate preview pass. For the others (e.g. PNG) that
+       pass would decode the whole file a second time, so we make
+       the preview from the full image instead.
+    */
+    const bool scaledPreview = wantPreview
+	&& rd.supportsOption( QImageIOHandler::ScaledSize );
+    if( scaledPreview )
+    {
+	QImageReader pr( impl->fileName );
+	pr.setScaledSize( psz );
+	const QImage prev( pr.read() );
+	if( this->cancelled() ) return;
+	if( ! prev.isNull() )
+	{
+	    Q_EMIT previewLoaded( prev, full );
+	}
+    }
+    const QImage img( rd.read() );
+    if( this->cancelled() ) return;
+    if( img.isNull() )
+    {
+	Q_EMIT loadFailed( QString("Could not read image [%1]: %2").
+			   arg(impl->fileName).
+			   arg(rd.errorString()) );
+	return;
+    }
+    if( wantPreview && ! scaledPreview )
+    { // Still worth it: the GUI thread shows this while converting the chunks.
+	Q_EMIT previewLoaded( img.scaled( psz, Qt::IgnoreAspectRatio, Qt::FastTransformation ), img.size() );
+	if( this->cancelled() ) return;
+    }
+    const QRect all( img.rect() );
+    for( int y = 0; y < all.height(); y += ChunkSize )
+    {
+	for( int x = 0; x < all.width(); x += ChunkSize )
+	{
+	    if( this->cancelled() ) return;
+	    const QRect r( QRect( x, y, ChunkSize, ChunkSize ).intersected( all ) );
+	    Q_EMIT tileLoaded( img.copy( r ), r );
+	}
+    }
+    Q_EMIT loadFinished();
+}
@@ -24,10 +24,13 @@
 #include <qboard/S11nQt/QList.h>
 #include <qboard/utility.h>
 #include <qboard/MenuHandlerGeneric.h>
+#include <qboard/PropertyID.h>
+#include <qboard/QBoardScene.h>
 #include <qboard/S11nQt/QPointF.h>
 
 #include <qboard/Dice.h>
 #include <time.h>
+#include <memory>
 
 namespace qboard {
 
@@ -150,11 +153,7 @@ void QGIDie::mousePressEvent(QGraphicsSceneMouseEvent *ev)
 	if( (ev->buttons() & Qt::LeftButton) )
 	{
 	    ev->accept();
-	    qreal zV = qboard::nextZLevel(this);
-	    if( zV > this->zValue() )
-	    {
-		this->setZValue(zV);
-	    }
+	    QGITypes::raiseItem( this );
 	}
 	this->QGraphicsTextItem::mousePressEvent(ev);
 }
@@ -196,58 +195,53 @@ void QGIDie::propertySet( char const *pname, QVariant const & var )
 {
     // FIXME: treat QVariant::Invalid appropriately for each property
     if(0) qDebug() << "QGIDie::propertySet("<<pname<<") val="<<var;
-    std::string key( pname );
-    if( "zLevel" == key )
+    switch( qboard::propertyID( pname ) )
     {
-	this->setZValue(var.toDouble());
-	return;
-    }
-    if( "pos" == key )
-    {
-	this->setPos( var.value<QPointF>() );
-	return;
-    }
-    if( "sides" == key )
-    {
-	impl->die.sides(var.toInt());
-	this->updateText();
-	return;
-    }
-    if( "low" == key )
-    {
-	impl->die.low(var.toInt());
-	this->updateText();
-	return;
-    }
-    if( "color" == key )
-    {
-	QColor old( impl->color );
-	impl->color = var.value<QColor>();
-	if( 255 == impl->color.alpha() )
-	{
-	    impl->color.setAlpha(old.alpha());
-	}
-	this->updateText();
-	return;
-    }
-    if( "scale" == key )
-    {
-	qreal scale = var.canConvert<qreal>() ? var.value<qreal>() : 1.0;
-	if( 0 == scale ) scale = 1.0;
-	qboard::rotateAndScale( this, 0, scale, scale, true);
-	return;
-    }
-    if( "dragDisabled" == key )
-    {
-	if( var.isValid() )
-	{
-	    this->setFlag( QGraphicsItem::ItemIsMovable, var.toInt() ? false : true );
-	}
-	else
-	{
-	    this->setFlag( QGraphicsItem::ItemIsMovable, true );
-	}
-	return;
+      case qboard::PropZLevel:
+	  this->setZValue(var.toDouble());
+	  QBoardScene::invalidateZOrder( this );
+	  return;
+      case qboard::PropPos:
+	  this->setPos( var.value<QPointF>() );
+	  return;
+      case qboard::PropSides:
+	  impl->die.sides(var.toInt());
+	  this->updateText();
+	  return;
+      case qboard::PropLow:
+	  impl->die.low(var.toInt());
+	  this->updateText();
+	  return;
+      case qboard::PropColor:
+      {
+	  QColor old( impl->color );
+	  impl->color = var.value<QColor>();
+	  if( 255 == impl->color.alpha() )
+	  {
+	      impl->color.setAlpha(old.alpha());
+	  }
+	  this->updateText();
+	  return;
+      }
+      case qboard::PropScale:
+      {
+	  qreal scale = var.canConvert<qreal>() ? var.value<qreal>() : 1.0;
+	  if( 0 == scale ) scale = 1.0;
+	  qboard::rotateAndScale( this, 0, scale, scale, true);
+	  return;
+      }
+      case qboard::PropDragDisabled:
+	  if( var.isValid() )
+	  {
+	      this->setFlag( QGraphicsItem::ItemIsMovable, var.toInt() ? false : true );
+	  }
+	  else
+	  {
+	      this->setFlag( QGraphicsItem::ItemIsMovable, true );
+	  }
+	  return;
+      default:
+	  return;
     }
 }
 
@@ -377,6 +371,16 @@ bool QGIDie::deserialize(  S11nNode const & src )
 		: true;
 }
 
+Serializable * QGIDie::clone() const
+{
+	std::auto_ptr<QGIDie> cl( new QGIDie );
+	cl->impl->die = impl->die;
+	cl->setPos( this->pos() );
+	qboard::clearProperties( cl.get() );
+	qboard::copyProperties( this, cl.get() );
+	return cl.release();
+}
+
 struct MenuHandlerDie::Impl
 {
     QGIDie * dot;
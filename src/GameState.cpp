@@ -18,7 +18,10 @@
 #include <QList>
 #include <QScriptEngine>
 #include <QScriptValueIterator>
+#include <QTime>
+#include <QTimer>
 
+#include <memory>
 #include <stdexcept>
 
 #include <qboard/S11nQt.h>
@@ -30,6 +33,7 @@
 #include <qboard/S11nQt/S11nClipboard.h>
 #include <qboard/ScriptQt.h>
 #include <qboard/S11nQt/QPoint.h>
+#include <qboard/S11nQt/QPixmap.h>
 #include <s11n.net/s11n/s11n_debuggering_macros.hpp>
 
 #include <qboard/QGIPiecePlacemarker.h>
@@ -37,6 +41,7 @@
 #include <qboard/JSQGI.h>
 #include <qboard/QBoardView.h>
 #include <qboard/JSQBoardView.h>
+#include <qboard/S11nFileThread.h>
 
 #define GAMESTATE_DOMETA_BOARDVIEW 1
 #if GAMESTATE_DOMETA_BOARDVIEW
@@ -47,23 +52,62 @@ struct GameState::Impl
 {
     QBoard board;
     QPointF placeAt;
-    QGraphicsScene * scene;
+    QBoardScene * scene;
     QScriptValue jsThis;
     QScriptEngine * js;
     QGIPiecePlacemarker * placer;
+    /** The running loadAsync()/saveAsync() file job. */
+    S11nFileThread * io;
+    /** The file name of the running loadAsync(). */
+    QString ioFile;
+    QString ioError;
+    /** The parsed tree loadAsync() is building items from. */
+    S11nNode * pending;
+    /** The "graphicsitems" node of pending, or 0. */
+    S11nNode const * pendingItems;
+    /** Index of the next child of pendingItems to materialize. */
+    int pendingPos;
+    /** Images shared by the items being loaded. See serialize(). */
+    s11n::qt::QPixmapTable pixmaps;
+    /** Deserialized items waiting to be added to the scene. */
+    QList<QGraphicsItem*> queued;
+    int materializeDone;
+    int materializeTotal;
+    /** True while items are being added from the event loop. */
+    bool materializing;
+    /** True if the current materialization comes from loadAsync(). */
+    bool loadingFile;
+    /** See setBatchedLoading(). */
+    bool batched;
+    QTimer * batchTimer;
     Impl() :
 	board(),
 	placeAt(50,50),
 	scene( new QBoardScene() ),
 	jsThis(),
 	js(0),
-	placer(0)
+	placer(0),
+	io(0),
+	ioFile(),
+	ioError(),
+	pending(0),
+	pendingItems(0),
+	pendingPos(0),
+	pixmaps(),
+	queued(),
+	materializeDone(0),
+	materializeTotal(0),
+	materializing(false),
+	loadingFile(false),
+	batched(false),
+	batchTimer(0)
     {
 	scene->setSceneRect( QRectF(0,0,200,200) );
 	scene->setObjectName("scene");
     }
     ~Impl()
     {
+	delete this->pending;
 	delete this->placer;
 	delete this->js;
 	delete this->scene;
@@ -175,11 +219,16 @@ GameState::~GameState()
     {
 	QObject::disconnect( impl->placer, SIGNAL(destroyed(QObject*)), this, SLOT(placemarkerDestroyed()) );
     }
+    this->abortIO();
     this->clear();
     delete impl;
 }
 void GameState::setup()
 {
+    impl->batchTimer = new QTimer(this);
+    impl->batchTimer->setInterval(0);
+    connect( impl->batchTimer, SIGNAL(timeout()), this, SLOT(materializeBatch()) );
+
     impl->js = qboard::createScriptEngine(this);
 
     QGITypes::setupJsEngine(impl->js);
@@ -326,6 +375,16 @@ QGraphicsScene * GameState::scene()
     return impl->scene;
 }
 
+QString GameState::sceneIndexMode() const
+{
+    return QBoardScene::indexModeToString( impl->scene->indexMode() );
+}
+
+void GameState::setSceneIndexMode( QString const & m )
+{
+    impl->scene->setIndexMode( QBoardScene::indexModeFromString(m) );
+}
+
 bool GameState::addItem( QGraphicsItem * it, bool autoPlace )
 {
     if( ! it ) return false;
@@ -338,18 +397,25 @@ bool GameState::addItem( QGraphicsItem * it, bool autoPlace )
 	it->setPos(pos);
     }
     impl->scene->addItem( it );
+    impl->scene->invalidateZOrder();
     return true;
 }
 
 
 void GameState::clear()
 {
+    if( impl->materializing )
+    {
+	impl->ioError = "Interrupted by GameState::clear().";
+	this->finishMaterializing( false );
+    }
     // Pieces should be cleared first, to avoid potential double or otherwise inappropriate
     // deletes due to the use QObject::deleteLater() in QGIGamePiece.
     impl->board.clear();
     QList<QGraphicsItem *> ql(impl->scene->items()); 
     //qDebug() <<"GameState::clear() trying to clear"<<ql.size()<<" QGI items";
     qboard::destroyToplevelItems( ql );
+    impl->scene->invalidateZOrder();
 }
 
 QBoard & GameState::board()
@@ -383,16 +449,53 @@ bool GameState::serialize( S11nNode & dest ) const
 	}
 	serItems.push_back(ser);
     }
-    return s11n::serialize_subnode( dest, "board", this->impl->board )
-	&& (serItems.isEmpty() ? true : s11nlite::serialize_subnode( dest, "graphicsitems", serItems ) )
-	;
+    /**
+       Games often have many pieces showing the same embedded
+       image. Collect the images in a table so that each one is
+       stored only once, and the pieces just refer to it.
+    */
+    s11n::qt::QPixmapTable pixmaps;
+    s11n::qt::QPixmapTable::Scope sentry( pixmaps );
+    if( ! s11n::serialize_subnode( dest, "board", this->impl->board )
+	|| ! s11n::serialize_subnode<S11nNode,Serializable>( dest, "scene", *this->impl->scene )
+	|| ! (serItems.isEmpty() ? true : s11nlite::serialize_subnode( dest, "graphicsitems", serItems ) ) )
+    {
+	return false;
+    }
+    if( ! pixmaps.count() ) return true;
+    std::auto_ptr<S11nNode> pch( NT::create( "pixmaps" ) );
+    if( ! pixmaps.serialize( *pch ) ) return false;
+    NT::children( dest ).push_back( pch.release() );
+    return true;
 }
 
-bool GameState::deserialize(  S11nNode const & src )
+bool GameState::deserializeSetup( S11nNode const & src )
 {
     if( ! this->Serializable::deserialize( src ) ) return false;
     this->clear();
+    impl->pixmaps.clear();
+    S11nNode const * ch = s11n::find_child_by_name(src, "pixmaps");
+    if( ch )
+    { // older games embed each item's images directly.
+	if( ! impl->pixmaps.deserialize( *ch ) ) return false;
+    }
+    s11n::qt::QPixmapTable::Scope sentry( impl->pixmaps );
     if( ! s11n::deserialize_subnode( src, "board", this->impl->board ) ) return false;
+    ch = s11n::find_child_by_name(src, "scene");
+    if( ch )
+    { // older games don't have this, and that's okay.
+	if( ! impl->scene->deserialize( *ch ) ) return false;
+    }
+    else
+    {
+	impl->scene->setIndexMode( QBoardScene::IndexAuto );
+    }
+    return true;
+}
+
+bool GameState::deserialize(  S11nNode const & src )
+{
+    if( ! this->deserializeSetup( src ) ) return false;
     S11nNode const * ch = s11n::find_child_by_name(src, "graphicsitems");
     if( ch )
     {
@@ -400,7 +503,13 @@ bool GameState::deserialize(  S11nNode const & src )
 	QL li;
 	try
 	{
-	    if( ! s11n::deserialize( *ch, li ) ) return false;
+	    {
+		s11n::qt::QPixmapTable::Scope sentry( impl->pixmaps );
+		const bool ok = s11n::deserialize( *ch, li );
+		impl->pixmaps.clear();
+		if( ! ok ) return false;
+	    }
+	    QList<QGraphicsItem*> gil;
 	    QL::iterator it = li.begin();
 	    QL::iterator et = li.end();
 	    for( ; et != it; ++it )
@@ -412,19 +521,270 @@ bool GameState::deserialize(  S11nNode const & src )
 		    s11n::cleanup_serializable( li );
 		    return false;
 		}
-		this->addItem( gi );
+		gil.push_back( gi );
 	    }
 	    li.clear();
+	    if( impl->batched )
+	    {
+		impl->queued = gil;
+		this->startMaterializing();
+		return true;
+	    }
+	    impl->scene->suspendIndex();
+	    for( int i = 0; i < gil.size(); ++i )
+	    {
+		this->addItem( gil.at(i) );
+	    }
+	    impl->scene->resumeIndex();
+	    return true;
 	}
 	catch(...)
 	{
+	    impl->pixmaps.clear();
 	    s11n::cleanup_serializable( li );
 	    qDebug() << "GameState::deserialize() caught exception. Cleaning up and passing it on.";
 	    throw;
 	}
     }
+    if( impl->batched )
+    { // for consistency, so clients can always wait on itemsMaterialized().
+	this->startMaterializing();
+    }
+    return true;
+}
+
+bool GameState::batchedLoading() const
+{
+    return impl->batched;
+}
+
+void GameState::setBatchedLoading( bool b )
+{
+    impl->batched = b;
+}
+
+bool GameState::isMaterializing() const
+{
+    return impl->materializing;
+}
+bool GameState::isBusy() const
+{
+    return impl->io || impl->materializing;
+}
+
+QString GameState::ioErrorString() const
+{
+    return impl->ioError;
+}
+
+bool GameState::loadAsync( QString const & fn )
+{
+    if( this->isBusy() || fn.isEmpty() ) return false;
+    impl->ioError.clear();
+    impl->ioFile = fn;
+    impl->io = new S11nFileThread( fn );
+    connect( impl->io, SIGNAL(jobDone(bool)), this, SLOT(ioJobDone(bool)) );
+    Q_EMIT ioProgress( 0, 0 );
+    impl->io->start();
+    return true;
+}
+
+bool GameState::saveAsync( QString const & fn, bool autoAddFileExtension )
+{
+    if( this->isBusy() || fn.isEmpty() ) return false;
+    impl->ioError.clear();
+    std::auto_ptr<S11nNode> root( new S11nNode );
+    try
+    {
+	if( ! s11nlite::serialize<Serializable>( *root, *this ) )
+	{
+	    impl->ioError = "Serialization of the game failed.";
+	    return false;
+	}
+    }
+    catch( std::exception const & ex )
+    {
+	impl->ioError = ex.what();
+	return false;
+    }
+    impl->io = new S11nFileThread( this->s11nSaveName( fn, autoAddFileExtension ),
+				   root.release() );
+    connect( impl->io, SIGNAL(jobDone(bool)), this, SLOT(ioJobDone(bool)) );
+    Q_EMIT ioProgress( 0, 0 );
+    impl->io->start();
     return true;
 }
+
+void GameState::cancelIO()
+{
+    if( impl->io )
+    { // ioJobDone() will finish up.
+	impl->io->cancel();
+    }
+    else if( impl->materializing )
+    {
+	impl->ioError = "Cancelled.";
+	this->finishMaterializing( false );
+    }
+}
+
+void GameState::abortIO()
+{
+    if( impl->io )
+    {
+	QObject::disconnect( impl->io, 0, this, 0 );
+	delete impl->io; // cancels and waits
+	impl->io = 0;
+    }
+    impl->loadingFile = false;
+    this->stopMaterializing();
+}
+
+void GameState::ioJobDone( bool ok )
+{
+    S11nFileThread * job = impl->io;
+    if( ! job || (this->sender() != job) ) return;
+    job->wait();
+    impl->io = 0;
+    impl->ioError = job->errorString();
+    const QString fn( job->fileName() );
+    if( S11nFileThread::Save == job->mode() )
+    {
+	delete job;
+	Q_EMIT saveFinished( fn, ok );
+	return;
+    }
+    std::auto_ptr<S11nNode> root( ok ? job->takeNode() : 0 );
+    delete job;
+    if( ! root.get() )
+    {
+	Q_EMIT loadFinished( fn, false );
+	return;
+    }
+    try
+    {
+	ok = this->deserializeSetup( *root );
+	if( ! ok )
+	{
+	    impl->ioError = QString("File [%1] does not contain a %2.").arg(fn).arg(this->s11nClass());
+	}
+    }
+    catch( std::exception const & ex )
+    {
+	impl->ioError = ex.what();
+	ok = false;
+    }
+    if( ! ok )
+    {
+	this->clear();
+	Q_EMIT loadFinished( fn, false );
+	return;
+    }
+    impl->pending = root.release();
+    impl->pendingItems = s11n::find_child_by_name( *impl->pending, "graphicsitems" );
+    impl->loadingFile = true;
+    this->startMaterializing();
+}
+
+void GameState::startMaterializing()
+{
+    impl->materializing = true;
+    impl->pendingPos = 0;
+    impl->materializeDone = 0;
+    impl->materializeTotal = impl->queued.size()
+	+ (impl->pendingItems ? int(S11nNodeTraits::children( *impl->pendingItems ).size()) : 0);
+    impl->scene->suspendIndex();
+    impl->batchTimer->start();
+}
+
+void GameState::stopMaterializing()
+{
+    if( ! impl->materializing ) return;
+    impl->materializing = false;
+    impl->batchTimer->stop();
+    qDeleteAll( impl->queued );
+    impl->queued.clear();
+    delete impl->pending;
+    impl->pending = 0;
+    impl->pendingItems = 0;
+    impl->pendingPos = 0;
+    impl->pixmaps.clear();
+    impl->scene->resumeIndex();
+}
+
+void GameState::finishMaterializing( bool ok )
+{
+    const bool fromFile = impl->loadingFile;
+    impl->loadingFile = false;
+    this->stopMaterializing();
+    if( ! ok )
+    {
+	this->clear();
+    }
+    Q_EMIT itemsMaterialized( ok );
+    if( fromFile )
+    {
+	Q_EMIT loadFinished( impl->ioFile, ok );
+    }
+}
+
+void GameState::materializeBatch()
+{
+    if( ! impl->materializing )
+    {
+	impl->batchTimer->stop();
+	return;
+    }
+    typedef S11nNode::child_list_type CL;
+    CL const * ch = impl->pendingItems ? &S11nNodeTraits::children( *impl->pendingItems ) : 0;
+    QTime slice;
+    slice.start();
+    try
+    {
+	do
+	{
+	    QGraphicsItem * gi = 0;
+	    if( ! impl->queued.isEmpty() )
+	    {
+		gi = impl->queued.takeFirst();
+	    }
+	    else if( ch && (impl->pendingPos < int(ch->size())) )
+	    {
+		S11nNode const * n = (*ch)[impl->pendingPos++];
+		s11n::qt::QPixmapTable::Scope sentry( impl->pixmaps );
+		Serializable * ser = s11nlite::deserialize<Serializable>( *n );
+		gi = dynamic_cast<QGraphicsItem*>( ser );
+		if( ! gi )
+		{
+		    if( ser ) s11n::cleanup_serializable<Serializable>( ser );
+		    impl->ioError = QString("Could not load item #%1 (class %2).").
+			arg(impl->pendingPos-1).arg(S11nNodeTraits::class_name(*n).c_str());
+		    this->finishMaterializing( false );
+		    return;
+		}
+	    }
+	    else
+	    {
+		break;
+	    }
+	    this->addItem( gi );
+	    ++impl->materializeDone;
+	}
+	while( slice.elapsed() < MaterializeSliceMs );
+    }
+    catch( std::exception const & ex )
+    {
+	impl->ioError = ex.what();
+	this->finishMaterializing( false );
+	return;
+    }
+    Q_EMIT ioProgress( impl->materializeDone, impl->materializeTotal );
+    if( impl->materializeDone >= impl->materializeTotal )
+    {
+	this->finishMaterializing( true );
+    }
+}
+
 static QGraphicsItem * firstSelectedQGI( QGraphicsScene * sc )
 {
     if( ! sc ) return 0;
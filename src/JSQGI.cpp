@@ -16,6 +16,7 @@
 #include <QScriptEngine>
 #include <qboard/ScriptQt.h>
 #include <qboard/utility.h>
+#include <qboard/QBoardScene.h>
 
 #define SELF(RV) QGraphicsItem *self = this->self(); \
     QScriptEngine * js = this->engine(); \
@@ -118,6 +119,7 @@ void JSQGI::setZValue( qreal z)
 {
     SELF();
     self->setZValue(z);
+    QBoardScene::invalidateZOrder( self );
 }
 qreal JSQGI::zValue()
 {
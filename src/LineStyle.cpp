@@ -0,0 +1,114 @@
+/*
+ * This file is (or was, at some point) part of the QBoard project
+ * (http://code.google.com/p/qboard)
+ *
+ * Copyright (c) 2008 Stephan Beal (http://wanderinghorse.net/home/stephan/)
+ *
+ * This file may be used under the terms of the GNU General Public
+ * License versions 2.0 or 3.0 as published by the Free Software
+ * Foundation and appearing in the files LICENSE.GPL2 and LICENSE.GPL3
+ * included in the packaging of this file.
+ *
+ */
+
+#include <qboard/LineStyle.h>
+#include <qboard/PropertyID.h>
+#include <qboard/S11nQt.h>
+
+namespace qboard {
+
+    LineStyle::LineStyle( QColor const & c,
+			  qreal w,
+			  Qt::PenStyle st,
+			  qreal asz )
+	: color(c),
+	  alpha(255),
+	  width(w),
+	  style(st),
+	  drawArrows(false),
+	  arrowSize(asz),
+	  defColor(c),
+	  defWidth(w),
+	  defStyle(st),
+	  defArrowSize(asz)
+    {
+    }
+
+    int LineStyle::set( char const * key, QVariant const & val )
+    {
+	switch( propertyID( key ) )
+	{
+	  case PropColor:
+	      color = val.isValid() ? val.value<QColor>() : defColor;
+	      return Appearance;
+	  case PropAlpha:
+	      if( ! val.isValid() )
+	      {
+		  alpha = 255;
+	      }
+	      else if( (QVariant::Int == val.type())
+		       || (QVariant::UInt == val.type())
+		       || (QVariant::LongLong == val.type())
+		       || (QVariant::ULongLong == val.type()) )
+	      {
+		  alpha = qBound( 0, val.toInt(), 255 );
+	      }
+	      else
+	      {
+		  const qreal a = val.toDouble();
+		  if( a > 1.0 )
+		  { // assume it's int-encoded
+		      alpha = qBound( 0, int(a), 255 );
+		  }
+		  else
+		  {
+		      QColor c;
+		      c.setAlphaF( qMax( qreal(0), a ) );
+		      alpha = c.alpha();
+		  }
+	      }
+	      return Appearance;
+	  case PropWidth:
+	      width = val.isValid() ? qMax( qreal(0), qreal(val.toDouble()) ) : defWidth;
+	      return Appearance | Geometry;
+	  case PropStyle:
+	      style = val.isValid()
+		  ? s11n::qt::stringToPenStyle( val.toString() )
+		  : defStyle;
+	      return Appearance;
+	  case PropDrawArrows:
+	      drawArrows = val.toInt() != 0;
+	      return Appearance | Geometry;
+	  case PropArrowSize:
+	      arrowSize = val.isValid() ? qreal(val.toDouble()) : defArrowSize;
+	      return Appearance | Geometry;
+	  default:
+	      return NoChange;
+	}
+    }
+
+    void LineStyle::setPen( QPen const & pen )
+    {
+	color = pen.color();
+	alpha = color.alpha();
+	width = pen.widthF();
+	style = pen.style();
+    }
+
+    QColor LineStyle::effectiveColor() const
+    {
+	QColor c( color );
+	c.setAlpha( alpha );
+	return c;
+    }
+
+    QPen LineStyle::pen( QPen const & base ) const
+    {
+	QPen p( base );
+	p.setColor( this->effectiveColor() );
+	p.setWidthF( width );
+	p.setStyle( style );
+	return p;
+    }
+
+} // namespace qboard
@@ -27,6 +27,7 @@
 #include <qboard/Serializable.h>
 #include <qboard/S11nQt.h>
 #include <qboard/S11nQt/QList.h>
+#include <qboard/QBoardScene.h>
 MenuHandlerCopyCut::MenuHandlerCopyCut(QGraphicsItem * gi,QObject * parent)
     : QObject(parent),
       m_gi(gi)
@@ -55,6 +56,7 @@ void MenuHandlerCopyCut::clipboard( QGraphicsItem * gvi, bool copy )
 	S11nClipboard::instance().serialize( *ser );
 	if( ! copy )
 	{
+	    QBoardScene::invalidateZOrder( gvi );
 	    QObject * obj = dynamic_cast<QObject *>( ser );
 	    if( obj )
 	    {
@@ -90,6 +92,7 @@ void MenuHandlerCopyCut::clipOne( QGraphicsItem * gi, bool copy )
     }
     if( ! copy )
     {
+	QBoardScene::invalidateZOrder( gi );
 	QObject * o = dynamic_cast<QObject*>(gi);
 	if( o )
 	{
@@ -190,6 +193,7 @@ void MenuHandlerCopyCut::cloneItem()
 	gi->setZValue( gi->zValue() + 0.001 );
 	gi->setParentItem( p.second->parentItem() );
 	sc->addItem( gi );
+	QBoardScene::invalidateZOrder( gi );
 	if( setSelection )
 	{
 	    gi->setSelected( true );
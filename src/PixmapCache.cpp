@@ -0,0 +1,159 @@
+/*
+ * This file is (or was, at some point) part of the QBoard project
+ * (http://code.google.com/p/qboard)
+ *
+ * Copyright (c) 2008 Stephan Beal (http://wanderinghorse.net/home/stephan/)
+ *
+ * This file may be used under the terms of the GNU General Public
+ * License versions 2.0 or 3.0 as published by the Free Software
+ * Foundation and appearing in the files LICENSE.GPL2 and LICENSE.GPL3
+ * included in the packaging of this file.
+ *
+ */
+
+#include <QCache>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+
+#include <qboard/PixmapCache.h>
+
+namespace qboard
+{
+    struct PixmapCache::Impl
+    {
+	/**
+	   Maps cache keys to pixmaps. QCache handles the LRU
+	   bookkeeping for us. The cost of each entry is its
+	   (approximate) decoded size in kilobytes.
+	*/
+	typedef QCache<QString,QPixmap> CacheType;
+	CacheType cache;
+	Impl() : cache( 64 * 1024 ) // 64MB
+	{
+	}
+	~Impl()
+	{
+	}
+
+	/**
+	   Returns the key for the given file, or an empty string if
+	   the file does not exist. Resource paths (":/...") have no
+	   meaningful mtime, but also never change, so that's okay.
+	*/
+	static QString makeKey( QString const & fn )
+	{
+	    QFileInfo fi( fn );
+	    if( ! fi.exists() ) return QString();
+	    QString path( fi.canonicalFilePath() );
+	    if( path.isEmpty() ) path = fi.absoluteFilePath();
+	    return QString("%1|%2").
+		arg(path).
+		arg(fi.lastModified().toTime_t());
+	}
+
+	static int costOf( QPixmap const & pix )
+	{
+	    const int c = (pix.width() * pix.height() * pix.depth() / 8) / 1024;
+	    return (c > 0) ? c : 1;
+	}
+
+	QPixmap find( QString const & key ) const
+	{
+	    QPixmap const * p = cache.object( key );
+	    return p ? *p : QPixmap();
+	}
+
+	void insert( QString const & key, QPixmap const & pix )
+	{
+	    // If the pixmap is bigger than the whole budget, QCache
+	    // refuses it (and deletes our copy), which is what we want.
+	    cache.insert( key, new QPixmap( pix ), costOf( pix ) );
+	}
+    };
+
+    PixmapCache::PixmapCache() : impl(new Impl)
+    {
+    }
+
+    PixmapCache::~PixmapCache()
+    {
+	delete impl;
+    }
+
+    static PixmapCache * pixmapCacheInstance = 0;
+    static void destroyPixmapCache()
+    {
+	delete pixmapCacheInstance;
+	pixmapCacheInstance = 0;
+    }
+
+    PixmapCache & PixmapCache::instance()
+    {
+	if( ! pixmapCacheInstance )
+	{
+	    pixmapCacheInstance = new PixmapCache;
+	    // QPixmaps must die before the QApplication does, so we
+	    // can't rely on a function-static instance here.
+	    qAddPostRoutine( destroyPixmapCache );
+	}
+	return *pixmapCacheInstance;
+    }
+
+    QPixmap PixmapCache::load( QString const & fn )
+    {
+	const QString key( Impl::makeKey( fn ) );
+	if( key.isEmpty() ) return QPixmap();
+	QPixmap pix( impl->find( key ) );
+	if( pix.isNull() && pix.load( fn ) )
+	{
+	    impl->insert( key, pix );
+	}
+	return pix;
+    }
+
+    QPixmap PixmapCache::load( QString const & fn, QSize const & sz )
+    {
+	QString key( Impl::makeKey( fn ) );
+	if( key.isEmpty() ) return QPixmap();
+	key += QString("|%1x%2").arg(sz.width()).arg(sz.height());
+	QPixmap pix( impl->find( key ) );
+	if( pix.isNull() && pix.load( fn ) )
+	{
+	    pix = pix.scaled( sz );
+	    impl->insert( key, pix );
+	}
+	return pix;
+    }
+
+    bool PixmapCache::find( QString const & key, QPixmap & dest )
+    {
+	QPixmap const * p = impl->cache.object( key );
+	if( ! p ) return false;
+	dest = *p;
+	return true;
+    }
+
+    void PixmapCache::insert( QString const & key, QPixmap const & pix )
+    {
+	if( key.isEmpty() || pix.isNull() ) return;
+	impl->insert( key, pix );
+    }
+
+    void PixmapCache::setBudget( int kbytes )
+    {
+	impl->cache.setMaxCost( (kbytes > 0) ? kbytes : 0 );
+    }
+
+    int PixmapCache::budget() const
+    {
+	return impl->cache.maxCost();
+    }
+
+    void PixmapCache::clear()
+    {
+	impl->cache.clear();
+    }
+
+} // namespace
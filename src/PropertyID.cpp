@@ -0,0 +1,131 @@
+/*
+ * This file is (or was, at some point) part of the QBoard project
+ * (http://code.google.com/p/qboard)
+ *
+ * Copyright (c) 2008 Stephan Beal (http://wanderinghorse.net/home/stephan/)
+ *
+ * This file may be used under the terms of the GNU General Public
+ * License versions 2.0 or 3.0 as published by the Free Software
+ * Foundation and appearing in the files LICENSE.GPL2 and LICENSE.GPL3
+ * included in the packaging of this file.
+ *
+ */
+
+#include <qboard/PropertyID.h>
+
+#include <cstring>
+
+namespace qboard {
+
+    namespace {
+	PropertyID lookupPropertyID( char const * n, int len )
+	{
+	    if( ! n || (len < 3) ) return PropUnknown;
+	    // Each case has exactly one candidate, so a single memcmp()
+	    // confirms (or rejects) the match.
+#define MATCH(S,ID) return (0 == std::memcmp(n,S,len)) ? ID : PropUnknown
+	    switch( len )
+	    {
+	      case 3:
+		  switch( n[0] )
+		  {
+		    case 'l': MATCH("low",PropLow);
+		    case 'p': MATCH("pos",PropPos);
+		  }
+		  break;
+	      case 4:
+		  switch( n[0] )
+		  {
+		    case 'h': MATCH("html",PropHtml);
+		    case 's': MATCH("size",PropSize);
+		  }
+		  break;
+	      case 5:
+		  switch( n[1] )
+		  {
+		    case 'l': MATCH("alpha",PropAlpha);
+		    case 'n': MATCH("angle",PropAngle);
+		    case 'o': MATCH("color",PropColor);
+		    case 'c': MATCH("scale",PropScale);
+		    case 'i':
+			if( 's' == n[0] ) MATCH("sides",PropSides);
+			MATCH("width",PropWidth);
+		    case 't': MATCH("style",PropStyle);
+		  }
+		  break;
+	      case 6:
+		  switch( n[0] )
+		  {
+		    case 'p': MATCH("pixmap",PropPixmap);
+		    case 'r': MATCH("radius",PropRadius);
+		    case 'z': MATCH("zLevel",PropZLevel);
+		  }
+		  break;
+	      case 9:
+		  MATCH("arrowSize",PropArrowSize);
+	      case 10:
+		  switch( n[0] )
+		  {
+		    case 'b': MATCH("borderSize",PropBorderSize);
+		    case 'c': MATCH("colorAlpha",PropAlpha);
+		    case 'd': MATCH("drawArrows",PropDrawArrows);
+		  }
+		  break;
+	      case 11:
+		  switch( n[6] )
+		  {
+		    case 'A': MATCH("borderAlpha",PropBorderAlpha);
+		    case 'C': MATCH("borderColor",PropBorderColor);
+		    case 'S': MATCH("borderStyle",PropBorderStyle);
+		  }
+		  break;
+	      case 12:
+		  MATCH("dragDisabled",PropDragDisabled);
+	      default:
+		  break;
+	    }
+#undef MATCH
+	    return PropUnknown;
+	}
+    }
+
+    PropertyID propertyID( char const * name )
+    {
+	return name ? lookupPropertyID( name, int(std::strlen(name)) ) : PropUnknown;
+    }
+
+    PropertyID propertyID( QByteArray const & name )
+    {
+	return lookupPropertyID( name.constData(), name.size() );
+    }
+
+    char const * propertyName( PropertyID id )
+    {
+	static char const * names[PropEND] = {
+	0, // PropUnknown
+	"alpha",
+	"angle",
+	"arrowSize",
+	"borderAlpha",
+	"borderColor",
+	"borderSize",
+	"borderStyle",
+	"color",
+	"dragDisabled",
+	"drawArrows",
+	"html",
+	"low",
+	"pixmap",
+	"pos",
+	"radius",
+	"scale",
+	"sides",
+	"size",
+	"style",
+	"width",
+	"zLevel"
+	};
+	return ((id > PropUnknown) && (id < PropEND)) ? names[id] : 0;
+    }
+
+} // namespace qboard
@@ -15,19 +15,34 @@
 
 #include <qboard/S11nQt.h>
 #include <qboard/S11nQt/QString.h>
+#include <qboard/PixmapCache.h>
+#include <qboard/BoardImageLoader.h>
 #include <QDebug>
+#include <QPainter>
 #include <QVariant>
 
 
 QBoard::QBoard() 
     : QObject(),
-      Serializable("QBoard")
+      Serializable("QBoard"),
+      m_file(),
+      m_px(),
+      m_loader(0),
+      m_loadSize()
 {
 }
 
 QBoard::~QBoard()
 {
     //qDebug() << "~QBoard()";
+    if( m_loader )
+    {
+	// The loader deletes itself (via deleteLater()) once its
+	// thread finishes, so we must not delete it ourselves.
+	BoardImageLoader * ld = m_loader;
+	this->cancelLoad();
+	ld->wait();
+    }
 }
 #include <QDynamicPropertyChangeEvent>
 bool QBoard::event( QEvent * e )
@@ -39,6 +54,7 @@ bool QBoard::event( QEvent * e )
 	    QString key(dev->propertyName());
 	    if( QString("pixmap") == key )
 	    {
+		this->cancelLoad();
 		QVariant var( this->property("pixmap") );
 		if( var.canConvert<QPixmap>() )
 		{
@@ -48,7 +64,11 @@ bool QBoard::event( QEvent * e )
 		else if( var.canConvert<QString>() )
 		{
 		    this->m_file = var.value<QString>();
-		    this->m_px = QPixmap(m_file);
+		    if( this->startProgressiveLoad( m_file ) )
+		    {
+			return true; // loadedBoard() will be emitted by the loader slots.
+		    }
+		    this->m_px = qboard::PixmapCache::instance().load(m_file);
 		}
 		Q_EMIT loadedBoard();
 	    }
@@ -143,7 +163,99 @@ bool QBoard::s11nSave( QString const & fn) const
 bool QBoard::loadPixmap( QString const & fn )
 {
     this->setProperty("pixmap",QVariant(fn));
-    return !m_px.isNull();
+    return (0 != m_loader) || !m_px.isNull();
+}
+
+bool QBoard::isLoading() const
+{
+    return 0 != m_loader;
+}
+
+bool QBoard::startProgressiveLoad( QString const & fn )
+{
+    const QSize sz( BoardImageLoader::imageSize( fn ) );
+    if( ! sz.isValid()
+	|| ((qint64(sz.width()) * sz.height()) < ProgressiveLoadThreshold) )
+    {
+	return false;
+    }
+    this->m_px = QPixmap();
+    this->m_loadSize = sz;
+    this->m_loader = new BoardImageLoader( fn );
+    connect( m_loader, SIGNAL(previewLoaded(QImage const &,QSize const &)),
+	     this, SLOT(loaderPreview(QImage const &,QSize const &)) );
+    connect( m_loader, SIGNAL(tileLoaded(QImage const &,QRect const &)),
+	     this, SLOT(loaderTile(QImage const &,QRect const &)) );
+    connect( m_loader, SIGNAL(loadFailed(QString const &)),
+	     this, SLOT(loaderFailed(QString const &)) );
+    connect( m_loader, SIGNAL(loadFinished()),
+	     this, SLOT(loaderFinished()) );
+    m_loader->start( QThread::LowPriority );
+    return true;
+}
+
+void QBoard::cancelLoad()
+{
+    if( ! m_loader ) return;
+    // The loader deletes itself when its thread finishes.
+    QObject::disconnect( m_loader, 0, this, 0 );
+    m_loader->cancel();
+    m_loader = 0;
+    m_loadSize = QSize();
+}
+
+bool QBoard::fromCurrentLoader() const
+{
+    return m_loader && (this->sender() == m_loader);
+}
+
+void QBoard::loaderPreview( QImage const & img, QSize const & full )
+{
+    if( ! this->fromCurrentLoader() ) return;
+    m_loadSize = full;
+    m_px = QPixmap( full );
+    m_px.fill( Qt::transparent );
+    {
+	QPainter p( &m_px );
+	p.setRenderHint( QPainter::SmoothPixmapTransform, true );
+	p.drawImage( QRect( QPoint(0,0), full ), img );
+    }
+    Q_EMIT loadedBoard();
+}
+
+void QBoard::loaderTile( QImage const & img, QRect const & where )
+{
+    if( ! this->fromCurrentLoader() ) return;
+    if( m_px.isNull() )
+    { // no preview was available
+	m_px = QPixmap( m_loadSize );
+	m_px.fill( Qt::transparent );
+	Q_EMIT loadedBoard();
+    }
+    {
+	QPainter p( &m_px );
+	p.setCompositionMode( QPainter::CompositionMode_Source );
+	p.drawImage( where.topLeft(), img );
+    }
+    Q_EMIT boardRegionLoaded( where );
+}
+
+void QBoard::loaderFailed( QString const & why )
+{
+    if( ! this->fromCurrentLoader() ) return;
+    qDebug() << "QBoard: progressive load failed:"<<why;
+    m_loader = 0; // it deletes itself
+    m_loadSize = QSize();
+    m_px = QPixmap();
+    Q_EMIT loadedBoard();
+}
+
+void QBoard::loaderFinished()
+{
+    if( ! this->fromCurrentLoader() ) return;
+    m_loader = 0; // it deletes itself
+    m_loadSize = QSize();
+    Q_EMIT loadedBoard();
 }
 
 bool QBoard::s11nLoad( QString const & fn )
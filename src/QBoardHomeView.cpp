@@ -29,7 +29,7 @@
 // it is loaded as a pixmap, scaled to 16x16, and used as its own icon.
 #define QBHomeView_GENERATE_MINIICONS 1
 #if QBHomeView_GENERATE_MINIICONS
-#include <QPixmapCache>
+#include <qboard/PixmapCache.h>
 #include <QRegExp>
 #endif
 
@@ -71,16 +71,7 @@ QIcon QBoardFileIconProvider::icon( const QFileInfo & info ) const
 	&& (0 == QRegExp("(png|xpm)",Qt::CaseInsensitive).indexIn(info.suffix()) )
 	)
     {
-	QString key( info.canonicalFilePath() );
-	QPixmap pix;
-	if( ! QPixmapCache::find(key,pix) )
-	{
-	    if( pix.load( key ) )
-	    {
-		pix = pix.scaled(16,16);
-		QPixmapCache::insert(key,pix);
-	    }
-	}
+	QPixmap pix( qboard::PixmapCache::instance().load( info.canonicalFilePath(), QSize(16,16) ) );
 	if( ! pix.isNull() )
 	{
 	    return QIcon(pix);
@@ -3,25 +3,133 @@
 #include <QGraphicsItem>
 #include <QDebug>
 #include <QEvent>
+#include <QTimer>
+#include <QGraphicsSceneMouseEvent>
+#include <QHash>
+#include <QMap>
+#include <QVector>
 #include <qboard/QBoardScene.h>
+#include <qboard/QGIPiece.h>
 #include <qboard/utility.h>
 
+#include <algorithm>
+#include <cmath>
+
 struct QBoardScene::Impl
 {
-    Impl()
+    /**
+       Scenes with fewer items than this are never indexed in
+       IndexAuto mode: a linear scan of a few hundred items is
+       cheaper than maintaining the BSP tree.
+    */
+    static const int SmallSceneLimit = 256;
+    /**
+       How often (in ms) IndexAuto mode re-evaluates its choice.
+    */
+    static const int SampleInterval = 1000;
+    /**
+       How many consecutive samples must agree before IndexAuto
+       switches index methods. Switching to BSP rebuilds the whole
+       tree, so we don't want to flip-flop.
+    */
+    static const int SwitchAfterSamples = 2;
+    QBoardScene::IndexMode mode;
+    QTimer sampler;
+    /** Number of item moves seen since the last sample. */
+    int moveCount;
+    /** Number of items moved by each drag event of the current drag. */
+    int dragWeight;
+    /** Index method the most recent sample(s) voted for. */
+    QGraphicsScene::ItemIndexMethod wanted;
+    int wantedCount;
+    /** suspendIndex() nesting level. */
+    int suspended;
+    /** Distance between neighbouring z-levels assigned by the z-order code. */
+    static const qreal ZStep;
+    /** Minimum number of raise/lower operations between rescans. */
+    static const int ZRescanInterval = 64;
+    /**
+       Top-level items by z-level, in stacking order. Removing or
+       deleting an item must go along with invalidateZOrder(), but
+       in case some code path misses that, the items are only
+       dereferenced after a rescan has rebuilt the map.
+    */
+    QMultiMap<qreal,QGraphicsItem*> zOrder;
+    /** The z-level each item in zOrder is filed under. */
+    QHash<QGraphicsItem*,qreal> zOf;
+    /** Raise/lower operations since the last rescan. */
+    int zOps;
+    /** True until the next rescan after invalidateZOrder(). */
+    bool zDirty;
+    Impl() :
+	mode(QBoardScene::IndexAuto),
+	sampler(),
+	moveCount(0),
+	dragWeight(1),
+	wanted(QGraphicsScene::NoIndex),
+	wantedCount(0),
+	suspended(0),
+	zOrder(),
+	zOf(),
+	zOps(0),
+	zDirty(true)
     {
+	sampler.setInterval( SampleInterval );
     }
     ~Impl()
     {
     }
+    void zForget( QGraphicsItem * it )
+    {
+	QHash<QGraphicsItem*,qreal>::iterator h = zOf.find( it );
+	if( zOf.end() == h ) return;
+	zOrder.remove( h.value(), it );
+	zOf.erase( h );
+    }
+    void zRecord( QGraphicsItem * it )
+    {
+	const qreal z = it->zValue();
+	zOf.insert( it, z );
+	zOrder.insert( z, it );
+    }
 };
+const qreal QBoardScene::Impl::ZStep = 1.0;
+
+/** Orders items by z-level, for use with std::stable_sort(). */
+static bool zLess( QGraphicsItem const * a, QGraphicsItem const * b )
+{
+    return a->zValue() < b->zValue();
+}
+
+/**
+   Returns the items from lst which are top-level items of sc, sorted
+   by z-level. The sort is stable. Newer Qt versions return
+   QGraphicsScene::items() topmost first, so passing reverse=true for
+   such a list keeps items with equal z-levels in painting order.
+*/
+static QList<QGraphicsItem*> zSortedTopLevel( QGraphicsScene const * sc,
+					      QList<QGraphicsItem*> const & lst,
+					      bool reverse )
+{
+    QList<QGraphicsItem*> top;
+    for( int i = 0; i < lst.size(); ++i )
+    {
+	QGraphicsItem * it = lst.at( reverse ? (lst.size() - 1 - i) : i );
+	if( it && !it->parentItem() && (it->scene() == sc) ) top.append( it );
+    }
+    std::stable_sort( top.begin(), top.end(), zLess );
+    return top;
+}
 
 QBoardScene::QBoardScene() : QGraphicsScene(),
     Serializable("QBoardScene"),
     impl(new Impl)
 {
+    // Start out unindexed: a fresh scene is empty, and IndexAuto
+    // will switch to BSP once the scene grows.
     this->setItemIndexMethod(QGraphicsScene::NoIndex);
-
+    connect( &impl->sampler, SIGNAL(timeout()), this, SLOT(sampleIndexUsage()) );
+    this->setIndexMode( IndexAuto );
 }
 
 QBoardScene::~QBoardScene()
@@ -62,7 +170,10 @@ void QBoardScene::drawItems( QPainter * painter,
 				QWidget * widget )
 {
 #if 1
-    this->QGraphicsScene::drawItems( painter, numItems, items, options, widget );
+    if( ! this->drawClusters( painter, numItems, items, options, widget ) )
+    {
+	this->QGraphicsScene::drawItems( painter, numItems, items, options, widget );
+    }
 #else
     // This only does what i want when GL mode is on.
     QPen linePen(Qt::red, 2, Qt::DotLine, Qt::FlatCap, Qt::MiterJoin);
@@ -75,10 +186,114 @@ void QBoardScene::drawItems( QPainter * painter,
     }
 #endif
 }
+
+namespace {
+    /** A group of pieces drawn as one glyph by drawClusters(). */
+    struct PieceCluster
+    {
+	/** Index of the topmost member in the drawItems() list. */
+	int top;
+	int count;
+	/** Combined scene bounds of the members. */
+	QRectF rect;
+    };
+}
+
+bool QBoardScene::drawClusters( QPainter * painter,
+				int numItems,
+				QGraphicsItem ** items,
+				const QStyleOptionGraphicsItem * options,
+				QWidget * widget )
+{
+    if( numItems < 2 ) return false;
+    const QTransform wt( painter->worldTransform() );
+    const qreal lod = std::sqrt( std::fabs( wt.m11() * wt.m22() - wt.m12() * wt.m21() ) );
+    // Pieces are never only a few pixels big at 1:1, so don't bother
+    // looking unless we're zoomed out.
+    if( (lod <= 0) || (lod >= 1) ) return false;
+    const qreal cell = QGIPiece::LodClusterPixels;
+    QVector<PieceCluster> clusters;
+    QVector<int> clusterOf( numItems, -1 );
+    QHash<quint64,int> cells;
+    bool any = false;
+    for( int i = 0; i < numItems; ++i )
+    {
+	QGraphicsItem * gi = items[i];
+	if( (QGITypes::QGIPiece != gi->type())
+	    || gi->parentItem()
+	    || gi->isSelected() ) continue;
+	const QRectF sbr( gi->sceneBoundingRect() );
+	if( (qMax( sbr.width(), sbr.height() ) * lod) >= cell ) continue;
+	const QPointF c( wt.map( sbr.center() ) );
+	const quint64 key = (quint64(quint32(qint32(std::floor( c.x() / cell )))) << 32)
+	    | quint32(qint32(std::floor( c.y() / cell )));
+	QHash<quint64,int>::const_iterator it = cells.constFind( key );
+	if( cells.constEnd() == it )
+	{
+	    PieceCluster cl;
+	    cl.top = i;
+	    cl.count = 1;
+	    cl.rect = sbr;
+	    cells.insert( key, clusters.count() );
+	    clusterOf[i] = clusters.count();
+	    clusters.append( cl );
+	}
+	else
+	{ // items come in stacking order, so i is the new top
+	    PieceCluster & cl( clusters[it.value()] );
+	    cl.top = i;
+	    ++cl.count;
+	    cl.rect |= sbr;
+	    clusterOf[i] = it.value();
+	    any = true;
+	}
+    }
+    if( ! any ) return false;
+    if(0) qDebug() << "QBoardScene::drawClusters():"<<numItems<<"items,"<<clusters.count()<<"cells";
+    QVector<QGraphicsItem *> runItems;
+    QVector<QStyleOptionGraphicsItem> runOpts;
+    runItems.reserve( numItems );
+    runOpts.reserve( numItems );
+    for( int i = 0; i < numItems; ++i )
+    {
+	const int id = clusterOf[i];
+	if( (id < 0) || (clusters[id].count < 2) )
+	{
+	    runItems.append( items[i] );
+	    runOpts.append( options[i] );
+	    continue;
+	}
+	PieceCluster const & cl( clusters[id] );
+	if( cl.top != i ) continue;
+	if( ! runItems.isEmpty() )
+	{ // draw what lies below this cluster first
+	    this->QGraphicsScene::drawItems( painter, runItems.count(), runItems.data(), runOpts.data(), widget );
+	    runItems.clear();
+	    runOpts.clear();
+	}
+	const QColor col( static_cast<QGIPiece *>( items[i] )->swatchColor() );
+	painter->save();
+	painter->setPen( QPen( (col.lightness() > 127) ? Qt::black : Qt::white, 0 ) );
+	painter->setBrush( col );
+	painter->drawRect( cl.rect );
+	painter->restore();
+    }
+    if( ! runItems.isEmpty() )
+    {
+	this->QGraphicsScene::drawItems( painter, runItems.count(), runItems.data(), runOpts.data(), widget );
+    }
+    return true;
+}
+
 bool QBoardScene::serialize( S11nNode & dest ) const
 {
     if( ! this->Serializable::serialize( dest ) ) return false;
     typedef S11nNodeTraits NT;
+    if( IndexAuto != impl->mode )
+    {
+	NT::set( dest, "indexMode",
+		 std::string( indexModeToString(impl->mode).toAscii().constData() ) );
+    }
     return true;
 }
 
@@ -86,9 +301,309 @@ bool QBoardScene::deserialize( S11nNode const & src )
 {
     if( ! this->Serializable::deserialize( src ) ) return false;
     typedef S11nNodeTraits NT;
+    std::string im( NT::get( src, "indexMode", std::string("auto") ) );
+    this->setIndexMode( indexModeFromString( im.c_str() ) );
     return true;
 }
 
+QBoardScene::IndexMode QBoardScene::indexModeFromString( QString const & s )
+{
+    const QString m( s.toLower() );
+    if( "bsp" == m ) return IndexBsp;
+    if( "none" == m ) return IndexNone;
+    return IndexAuto;
+}
+
+QString QBoardScene::indexModeToString( IndexMode m )
+{
+    switch( m )
+    {
+      case IndexBsp: return "bsp";
+      case IndexNone: return "none";
+      default: break;
+    };
+    return "auto";
+}
+
+QBoardScene::IndexMode QBoardScene::indexMode() const
+{
+    return impl->mode;
+}
+
+void QBoardScene::setIndexMode( IndexMode m )
+{
+    impl->mode = m;
+    impl->moveCount = 0;
+    impl->wantedCount = 0;
+    if( impl->suspended ) return; // resumeIndex() will apply it
+    if( IndexAuto == m )
+    {
+	impl->wanted = this->itemIndexMethod();
+	impl->sampler.start();
+	this->sampleIndexUsage();
+	return;
+    }
+    impl->sampler.stop();
+    const QGraphicsScene::ItemIndexMethod im = (IndexBsp == m)
+	? QGraphicsScene::BspTreeIndex
+	: QGraphicsScene::NoIndex;
+    if( im != this->itemIndexMethod() )
+    {
+	this->setItemIndexMethod( im );
+    }
+}
+
+void QBoardScene::suspendIndex()
+{
+    if( 1 != ++impl->suspended ) return;
+    impl->sampler.stop();
+    if( QGraphicsScene::NoIndex != this->itemIndexMethod() )
+    {
+	this->setItemIndexMethod( QGraphicsScene::NoIndex );
+    }
+}
+
+void QBoardScene::resumeIndex()
+{
+    if( (impl->suspended <= 0) || (0 != --impl->suspended) ) return;
+    if( IndexAuto != impl->mode )
+    {
+	this->setIndexMode( impl->mode );
+	return;
+    }
+    const QGraphicsScene::ItemIndexMethod want =
+	(this->items().size() < Impl::SmallSceneLimit)
+	? QGraphicsScene::NoIndex
+	: QGraphicsScene::BspTreeIndex;
+    impl->moveCount = 0;
+    impl->wanted = want;
+    impl->wantedCount = 0;
+    if( want != this->itemIndexMethod() )
+    {
+	if( QGraphicsScene::BspTreeIndex == want )
+	{
+	    this->setBspTreeDepth( 0 );
+	}
+	this->setItemIndexMethod( want );
+    }
+    impl->sampler.start();
+}
+
+bool QBoardScene::isIndexSuspended() const
+{
+    return impl->suspended > 0;
+}
+
+void QBoardScene::sampleIndexUsage()
+{
+    if( (IndexAuto != impl->mode) || impl->suspended ) return;
+    const int count = this->items().size();
+    const int moved = impl->moveCount;
+    impl->moveCount = 0;
+    /**
+       Every moved item has to be re-inserted into the BSP tree, so
+       when a large part of the scene is being dragged around (e.g. a
+       big selection) the tree costs more than it saves. Otherwise,
+       once the scene is big enough, hit tests dominate and BSP wins.
+    */
+    QGraphicsScene::ItemIndexMethod want = QGraphicsScene::BspTreeIndex;
+    if( (count < Impl::SmallSceneLimit)
+	|| (moved > (count / 8)) )
+    {
+	want = QGraphicsScene::NoIndex;
+    }
+    if( want != impl->wanted )
+    {
+	impl->wanted = want;
+	impl->wantedCount = 0;
+    }
+    if( (++impl->wantedCount < Impl::SwitchAfterSamples)
+	|| (want == this->itemIndexMethod()) )
+    {
+	return;
+    }
+    if(0) qDebug() << "QBoardScene::sampleIndexUsage(): items ="<<count
+		   << "moved ="<<moved
+		   << "switching to"<<((QGraphicsScene::BspTreeIndex == want) ? "BSP" : "NoIndex");
+    if( QGraphicsScene::BspTreeIndex == want )
+    {
+	this->setBspTreeDepth( 0 ); // let Qt pick the depth for the current item count
+    }
+    this->setItemIndexMethod( want );
+}
+
+void QBoardScene::normalizeZLevels()
+{
+    QList<QGraphicsItem*> top( zSortedTopLevel( this, this->items(), true ) );
+    impl->zOrder.clear();
+    impl->zOf.clear();
+    impl->zOps = 0;
+    impl->zDirty = false;
+    for( int i = 0; i < top.size(); ++i )
+    {
+	QGraphicsItem * it = top.at(i);
+	const qreal z = i * Impl::ZStep;
+	if( it->zValue() != z ) it->setZValue( z );
+	impl->zRecord( it );
+    }
+}
+
+void QBoardScene::zMaybeRescan()
+{
+    if( ! impl->zDirty
+	&& (impl->zOps < qMax( int(Impl::ZRescanInterval), impl->zOf.size() )) )
+    {
+	return;
+    }
+    QList<QGraphicsItem*> top( zSortedTopLevel( this, this->items(), true ) );
+    /**
+       Renormalize if z-levels collide (Qt's order for equal z-levels
+       is arbitrary as far as users are concerned) or if they have
+       spread out far more than the item count needs. Otherwise just
+       re-learn them, so that loading and saving a game does not
+       rewrite every item's z-level.
+    */
+    bool renorm = false;
+    for( int i = 1; !renorm && (i < top.size()); ++i )
+    {
+	renorm = (top.at(i-1)->zValue() == top.at(i)->zValue());
+    }
+    if( !renorm && (top.size() > 1) )
+    {
+	const qreal spread = top.last()->zValue() - top.first()->zValue();
+	renorm = spread > (4 * Impl::ZStep * top.size());
+    }
+    if( renorm )
+    {
+	this->normalizeZLevels();
+	return;
+    }
+    impl->zOrder.clear();
+    impl->zOf.clear();
+    impl->zOps = 0;
+    impl->zDirty = false;
+    for( int i = 0; i < top.size(); ++i )
+    {
+	impl->zRecord( top.at(i) );
+    }
+}
+
+void QBoardScene::invalidateZOrder()
+{
+    impl->zOrder.clear();
+    impl->zOf.clear();
+    impl->zOps = 0;
+    impl->zDirty = true;
+}
+
+void QBoardScene::invalidateZOrder( QGraphicsItem * item )
+{
+    QBoardScene * sc = item ? qobject_cast<QBoardScene*>( item->scene() ) : 0;
+    if( sc ) sc->invalidateZOrder();
+}
+
+bool QBoardScene::raiseItems( QList<QGraphicsItem*> const & items )
+{
+    this->zMaybeRescan();
+    QList<QGraphicsItem*> mine( zSortedTopLevel( this, items, false ) );
+    if( mine.isEmpty() ) return false;
+    ++impl->zOps;
+    for( int i = 0; i < mine.size(); ++i )
+    {
+	impl->zForget( mine.at(i) );
+    }
+    if( impl->zOrder.isEmpty()
+	|| (mine.first()->zValue() > (impl->zOrder.constEnd() - 1).key()) )
+    { // already on top
+	for( int i = 0; i < mine.size(); ++i )
+	{
+	    impl->zRecord( mine.at(i) );
+	}
+	return false;
+    }
+    bool changed = false;
+    qreal z = (impl->zOrder.constEnd() - 1).key();
+    for( int i = 0; i < mine.size(); ++i )
+    {
+	QGraphicsItem * it = mine.at(i);
+	z += Impl::ZStep;
+	if( it->zValue() != z )
+	{
+	    it->setZValue( z );
+	    changed = true;
+	}
+	impl->zRecord( it );
+    }
+    return changed;
+}
+
+bool QBoardScene::raiseItem( QGraphicsItem * item )
+{
+    return this->raiseItems( QList<QGraphicsItem*>() << item );
+}
+
+bool QBoardScene::lowerItems( QList<QGraphicsItem*> const & items )
+{
+    this->zMaybeRescan();
+    QList<QGraphicsItem*> mine( zSortedTopLevel( this, items, false ) );
+    if( mine.isEmpty() ) return false;
+    ++impl->zOps;
+    for( int i = 0; i < mine.size(); ++i )
+    {
+	impl->zForget( mine.at(i) );
+    }
+    if( impl->zOrder.isEmpty()
+	|| (mine.last()->zValue() < impl->zOrder.constBegin().key()) )
+    { // already at the bottom
+	for( int i = 0; i < mine.size(); ++i )
+	{
+	    impl->zRecord( mine.at(i) );
+	}
+	return false;
+    }
+    bool changed = false;
+    qreal z = impl->zOrder.constBegin().key();
+    for( int i = mine.size() - 1; i >= 0; --i )
+    {
+	QGraphicsItem * it = mine.at(i);
+	z -= Impl::ZStep;
+	if( it->zValue() != z )
+	{
+	    it->setZValue( z );
+	    changed = true;
+	}
+	impl->zRecord( it );
+    }
+    return changed;
+}
+
+bool QBoardScene::lowerItem( QGraphicsItem * item )
+{
+    return this->lowerItems( QList<QGraphicsItem*>() << item );
+}
+
+void QBoardScene::mousePressEvent( QGraphicsSceneMouseEvent * ev )
+{
+    this->QGraphicsScene::mousePressEvent( ev );
+    if( IndexAuto == impl->mode )
+    {
+	// A drag moves the whole selection (or just the grabbed item).
+	const int sel = this->selectedItems().size();
+	impl->dragWeight = (sel > 0) ? sel : 1;
+    }
+}
+
+void QBoardScene::mouseMoveEvent( QGraphicsSceneMouseEvent * ev )
+{
+    if( (IndexAuto == impl->mode)
+	&& (ev->buttons() & Qt::LeftButton)
+	&& this->mouseGrabberItem() )
+    {
+	impl->moveCount += impl->dragWeight;
+    }
+    this->QGraphicsScene::mouseMoveEvent( ev );
+}
+
 
 bool QBoardScene::event( QEvent * event )
 {
@@ -33,12 +33,15 @@
 
 
 #include <qboard/QBoard.h>
+#include <qboard/TiledPixmap.h>
 #include <qboard/utility.h>
 
 struct QBoardView::Impl
 {
     GameState & gs;
     QBoard & board;
+    /** Draws the board's pixmap in drawBackground(). */
+    qboard::TiledPixmap tiles;
     qreal scale;
     bool glmode;
     QPoint placeAt;
@@ -46,6 +49,7 @@ struct QBoardView::Impl
     Impl(GameState & s)
 	: gs(s),
 	  board(s.board()),
+	  tiles(),
 	  scale(1.0),
 	  glmode(false),
 	  placeAt(50,50),
@@ -64,6 +68,7 @@ QBoardView::QBoardView( GameState & gs ) :
     this->setProperty("scale", 1.0);
     this->setProperty("angle", 0.0);
     connect( &impl->board, SIGNAL(loadedBoard()), this, SLOT(updateBoardPixmap()) );
+    connect( &impl->board, SIGNAL(boardRegionLoaded(QRect const &)), this, SLOT(updateBoardRegion(QRect const &)) );
     this->setAlignment(Qt::AlignLeft | Qt::AlignTop);
     this->setInteractive(true);
     //this->setTransformationAnchor(QGraphicsView::NoAnchor);
@@ -131,6 +136,13 @@ void QBoardView::refreshTransformation()
     qboard::rotateAndScale( this,
 			    this->property("angle").toDouble(),
 			    this->property("scale").toDouble() );
+#if QT_VERSION >= 0x040600
+    // QBoardScene::drawItems() draws the piece clusters, but since
+    // 4.6 Qt only calls it on the slower indirect painting path, so
+    // only take that path when zoomed out far enough to cluster.
+    const qreal lod = std::sqrt( std::fabs( this->transform().determinant() ) );
+    this->setOptimizationFlag( QGraphicsView::IndirectPainting, lod < 1 );
+#endif
     this->updateGeometry(); // ensure scrollbars get synced
 }
 
@@ -278,6 +290,7 @@ QSize QBoardView::sizeHint() const
 }
 void QBoardView::updateBoardPixmap()
 {
+    impl->tiles.setPixmap( &impl->board.pixmap() );
     //this->setBackgroundBrush(impl->board.pixmap());
     //if( impl->board.pixmap().isNull() ) return;
     if( ! impl->board.pixmap().isNull() )
@@ -295,6 +308,12 @@ void QBoardView::updateBoardPixmap()
     this->updateGeometry();
 }
 
+void QBoardView::updateBoardRegion( QRect const & r )
+{
+    impl->tiles.invalidate( r );
+    this->viewport()->update( this->mapFromScene( QRectF(r) ).boundingRect() );
+}
+
 void QBoardView::drawBackground( QPainter *p, const QRectF & rect )
 {
     if( this->impl->board.pixmap().isNull() )
@@ -310,8 +329,8 @@ void QBoardView::drawBackground( QPainter *p, const QRectF & rect )
 	    //p->fillRect( rect, this->backgroundBrush() );
 	}
 #endif
-	QRect bogo = impl->board.pixmap().rect();
-	p->drawPixmap(bogo, impl->board.pixmap(), bogo );
+	// Only draw the parts of the board which were actually exposed:
+	impl->tiles.draw( p, rect );
     }
    
 }
@@ -9,6 +9,7 @@
 
 #include <qboard/QGI.h>
 #include <qboard/utility.h>
+#include <qboard/QBoardScene.h>
 #include <qboard/QGIPiece.h>
 #include <qboard/QGIDot.h>
 #include <qboard/QGIHtml.h>
@@ -52,11 +53,36 @@ bool QGITypes::handleClickRaise( QGraphicsItem * it,
 	)
     {
 	bool high = (ev->buttons() & Qt::LeftButton);
-	qreal zV = qboard::nextZLevel(it,high);
-	if( zV != it->zValue() )
+	QBoardScene * sc = it->isSelected()
+	    ? qobject_cast<QBoardScene*>( it->scene() )
+	    : 0;
+	if( sc )
 	{
-	    it->setZValue( zV );
+	    QList<QGraphicsItem*> sel( sc->selectedItems() );
+	    if( sel.size() > 1 )
+	    {
+		return high ? sc->raiseItems( sel ) : sc->lowerItems( sel );
+	    }
 	}
+	return raiseItem( it, high );
+    }
+    return false;
+}
+
+bool QGITypes::raiseItem( QGraphicsItem * it, bool high )
+{
+    if( ! it ) return false;
+    QBoardScene * sc = it->parentItem()
+	? 0
+	: qobject_cast<QBoardScene*>( it->scene() );
+    if( sc )
+    {
+	return high ? sc->raiseItem( it ) : sc->lowerItem( it );
+    }
+    qreal zV = qboard::nextZLevel(it,high);
+    if( zV != it->zValue() )
+    {
+	it->setZValue( zV );
 	return true;
     }
     return false;
@@ -101,5 +127,6 @@ void QGITypes::shuffleQGIList( QList<QGraphicsItem*> list, bool skipParentedItem
 	gi->setPos( pts[x] );
 	gi->setZValue( zvals[x] );
     }
+    QBoardScene::invalidateZOrder( vec[0] );
     return;
 }
@@ -12,10 +12,13 @@
  */
 
 #include <qboard/QGIDot.h>
+#include <qboard/PropertyID.h>
+#include <qboard/LineStyle.h>
 #include <qboard/S11nQt.h>
 #include <qboard/utility.h>
 #include <qboard/MenuHandlerGeneric.h>
 #include <qboard/S11nQt/QList.h>
+#include <qboard/QBoardScene.h>
 #include <QGraphicsSceneMouseEvent>
 #include <QStyleOptionGraphicsItem>
 #include <QGraphicsScene>
@@ -30,6 +33,7 @@
 #include <QMenu>
 #include <QEvent>
 #include <cmath> // acos()
+#include <memory>
 
 #include <qboard/S11nQt/QBrush.h>
 #include <qboard/S11nQt/QPen.h>
@@ -46,18 +50,6 @@ struct QGIDot::Impl
     QBrush brush;
     QGIDot::EdgeList edges;
     QGIDotLine * inLine;
-    enum PropIDs {
-    PropUnknown = 0,
-    PropAlpha,
-    PropAngle,
-    PropColor,
-    PropDragDisabled,
-    PropPos,
-    PropRadius,
-    PropScale,
-    PropZLevel,
-    PropEND
-    };
     Impl() : active(false),
 	     radius(12),
 	     color(Qt::red),
@@ -81,21 +73,16 @@ struct QGIDotLine::Impl
     qreal arrowSize;
     QBrush brush;
     QPen pen;
-    enum PropIDs {
-    PropUnknown = 0,
-    PropAlpha,
-    PropColor,
-    PropStyle,
-    PropWidth,
-    PropEND
-    };
+    /** Typed copy of our style properties. pen is built from it. */
+    qboard::LineStyle style;
     Impl() : src(0),
 	     dest(0),
 	     pSrc(),
 	     pDest(),
 	     arrowSize(16),
 	     brush(QColor(Qt::red)),
-	     pen(brush,3,Qt::SolidLine,Qt::RoundCap,Qt::RoundJoin)
+	     pen(brush,3,Qt::SolidLine,Qt::RoundCap,Qt::RoundJoin),
+	     style(QColor(Qt::red),3,Qt::SolidLine)
     {
     }
     ~Impl()
@@ -212,41 +199,25 @@ void QGIDot::refreshTransformation()
 
 void QGIDot::propertySet( char const *pname, QVariant const & var )
 {
-    typedef QMap<QString,int> PMAP;
-    static PMAP pmap;
-    if( pmap.isEmpty() )
-    {
-#define MAP(S,V) pmap[S] = Impl::V;
-	MAP("color",PropColor);
-	MAP("alpha",PropAlpha);
-	MAP("colorAlpha",PropAlpha);
-	MAP("zLevel",PropZLevel);
-	MAP("pos",PropPos);
-	MAP("scale",PropScale);
-	MAP("angle",PropAngle);
-	MAP("radius",PropRadius);
-	MAP("dragDisabled",PropDragDisabled);
-
-#undef MAP
-    }
-    int kid = pmap.value( QString(pname?pname:""), Impl::PropUnknown );
-    if( Impl::PropUnknown == kid ) return;
+    const int kid = qboard::propertyID( pname );
+    if( qboard::PropUnknown == kid ) return;
 
     // FIXME: treat QVariant::Invalid appropriately for each property
     if(0) qDebug() << "QGIDot::propertySet("<<pname<<") val="<<var;
-    if( Impl::PropZLevel == kid )
+    if( qboard::PropZLevel == kid )
     {
 	this->setZValue(var.toDouble());
+	QBoardScene::invalidateZOrder( this );
 	this->update();
 	return;
     }
-    if( Impl::PropPos == kid )
+    if( qboard::PropPos == kid )
     {
 	this->setPos( var.value<QPointF>() );
 	this->update();
 	return;
     }
-    if( Impl::PropColor == kid )
+    if( qboard::PropColor == kid )
     {
 	QColor old( impl->color );
 	impl->color = var.value<QColor>();
@@ -258,7 +229,7 @@ void QGIDot::propertySet( char const *pname, QVariant const & var )
 	this->update();
 	return;
     }
-    if( Impl::PropAlpha == kid )
+    if( qboard::PropAlpha == kid )
     {
 	qreal a = var.toDouble();
 	if( a > 1 )
@@ -273,12 +244,12 @@ void QGIDot::propertySet( char const *pname, QVariant const & var )
     	this->update();
 	return;
     }
-    if( (Impl::PropScale == kid) || (Impl::PropAngle == kid) )
+    if( (qboard::PropScale == kid) || (qboard::PropAngle == kid) )
     {
 	this->refreshTransformation();
 	return;
     }
-    if( Impl::PropRadius == kid )
+    if( qboard::PropRadius == kid )
     {
 	impl->radius = var.value<qreal>();
 	this->prepareGeometryChange();
@@ -286,7 +257,7 @@ void QGIDot::propertySet( char const *pname, QVariant const & var )
 	this->update();
 	return;
     }
-    if( Impl::PropDragDisabled == kid )
+    if( qboard::PropDragDisabled == kid )
     {
 	if( var.isValid() )
 	{
@@ -475,22 +446,32 @@ void QGIDot::split()
 
 Serializable * QGIDot::clone() const
 {
-    Serializable * s = this->Serializable::clone();
-//     if( ! s ) return 0;
-//     QGIDot * cl = static_cast<QGIDot*>(s);
-//     if( ! cl )
-//     {
-// 	delete s;
-// 	s = 0;
-//     }
-//     while(s)
-//     {
-// 	QGraphicsItem * parent = this->parentItem();
-// 	if( ! parent ) break;
-// 	if( parent->type() != QGIType::QGIDotLine ) break;
-// 	QGIDotLine
-//     }
-    return s;
+    std::auto_ptr<QGIDot> cl( new QGIDot );
+    QList<QGraphicsItem *> chgi( qboard::childItems(this) );
+    if( ! chgi.isEmpty() )
+    {
+	typedef QList<QGraphicsItem *> QGIL;
+	QGIL childs;
+	if( -1 == s11n::qt::cloneQGIList<Serializable>( chgi, childs ) )
+	{
+	    return this->Serializable::clone();
+	}
+	Q_FOREACH( QGraphicsItem * it, childs )
+	{
+	    QGIDotLine * d = (it->type() == QGITypes::QGIDotLine)
+		? dynamic_cast<QGIDotLine*>(it)
+		: 0;
+	    if( d ) d->setSourceNode( cl.get() );
+	    else it->setParentItem( cl.get() );
+	}
+    }
+    QObject props;
+    qboard::copyProperties( this, &props );
+    props.setProperty("alpha", impl->color.alpha());
+    props.setProperty("pos", this->pos() );
+    props.setProperty("zLevel", this->zValue() );
+    qboard::copyProperties( &props, cl.get() );
+    return cl.release();
 }
 
 bool QGIDot::serialize( S11nNode & dest ) const
@@ -729,8 +710,7 @@ QRectF QGIDotLine::boundingRect() const
     if (!impl->src || !impl->dest)
         return QRectF();
 
-    qreal penWidth = 1;
-    qreal extra = (penWidth + impl->arrowSize) / 2.0;
+    qreal extra = (impl->style.width + impl->arrowSize) / 2.0;
 
     QSizeF d(impl->pDest.x() - impl->pSrc.x(),
 	     impl->pDest.y() - impl->pSrc.y());
@@ -828,52 +808,11 @@ QGIDot * QGIDotLine::destNode()
 void QGIDotLine::propertySet( char const *pname,
 			      QVariant const & var )
 {
-    if( ! pname ) return;
-    typedef QMap<QString,int> PMAP;
-    static PMAP pmap;
-    if( pmap.isEmpty() )
-    {
-#define MAP(S,V) pmap[S] = Impl::V;
-	MAP("alpha",PropAlpha);
-	MAP("colorAlpha",PropAlpha);
-	MAP("color",PropColor);
-	MAP("style",PropStyle);
-	MAP("width",PropWidth);
-#undef MAP
-    }
-    int kid = pmap.value( QString(pname?pname:""), Impl::PropUnknown );
-    if( Impl::PropUnknown == kid ) return;
-
+    const int ch = impl->style.set( pname, var );
+    if( ! ch ) return;
     if(0) qDebug() << "QGIDotLine::propertySet("<<pname<<") val="<<var;
-    QString key( pname );
-    if( Impl::PropWidth == kid )
-    {
-	impl->pen.setWidth( var.toInt() );
-    }
-    else if( Impl::PropColor == kid )
-    {
-	QColor newcol( var.value<QColor>() );
-	newcol.setAlphaF( impl->pen.color().alphaF() );
-	impl->pen.setColor( newcol );
-    }
-    else if( Impl::PropAlpha == kid )
-    {
-	qreal a = var.toDouble();
-	QColor col = impl->pen.color();
-	if( a > 1.0 )
-	{ // assume it's int-encoded
-	    col.setAlpha( int(a) );
-	}
-	else
-	{
-	    col.setAlphaF( a );
-	}
-	impl->pen.setColor(col);
-    }
-    else if( Impl::PropStyle == kid )
-    {
-	impl->pen.setStyle( Qt::PenStyle( s11n::qt::stringToPenStyle(var.toString()) ) );
-    }
+    if( ch & qboard::LineStyle::Geometry ) this->prepareGeometryChange();
+    impl->pen = impl->style.pen( impl->pen );
     this->setPen(impl->pen);
     this->update();
 }
@@ -918,6 +857,7 @@ bool QGIDotLine::deserialize( S11nNode const & src )
     qboard::destroyQGIList( qboard::childItems(this) );
     //typedef S11nNodeTraits NT;
     s11nlite::deserialize_subnode( src, "pen", impl->pen );
+    impl->style.setPen( impl->pen );
     this->setPen( impl->pen );
     S11nNode const * ch = 0;
     ch = s11n::find_child_by_name(src, "dest");
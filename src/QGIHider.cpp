@@ -1,4 +1,5 @@
 #include <qboard/QGIHider.h>
+#include <qboard/PropertyID.h>
 
 #include <QGraphicsSceneMouseEvent>
 #include <QStyleOptionGraphicsItem>
@@ -8,10 +9,12 @@
 #include <QWidget>
 #include <QMenu>
 #include <QGraphicsPixmapItem>
+#include <memory>
 
 #include <qboard/S11nQt.h>
 #include <qboard/utility.h>
 #include <qboard/MenuHandlerGeneric.h>
+#include <qboard/QBoardScene.h>
 #include <qboard/S11nQt/QPointF.h>
 #include <qboard/S11nQt/QBrush.h>
 #include <qboard/S11nQt/QTransform.h>
@@ -21,18 +24,6 @@ struct QGIHider::Impl
     QGraphicsItem * item;
     QPen pen;
     //QBrush brush;
-    enum PropIDs {
-    PropUnknown = 0,
-    PropAlpha,
-    PropAngle,
-    PropColor,
-    PropDragDisabled,
-    PropPos,
-    PropRadius,
-    PropScale,
-    PropZLevel,
-    PropEND
-    };
     Impl()
 	: item(0),
 	  pen()
@@ -77,43 +68,39 @@ void QGIHider::refreshTransformation()
 
 void QGIHider::propertySet( char const *pname, QVariant const & var )
 {
-    typedef QMap<QString,int> PMAP;
-    static PMAP pmap;
-    if( pmap.isEmpty() )
-    {
-#define MAP(S,V) pmap[S] = Impl::V;
-	MAP("color",PropColor);
-	MAP("alpha",PropAlpha);
-	MAP("zLevel",PropZLevel);
-	MAP("pos",PropPos);
-	//MAP("scale",PropScale);
-	//MAP("angle",PropAngle);
-	//MAP("dragDisabled",PropDragDisabled);
-#undef MAP
-    }
-    int kid = pmap.value( QString(pname?pname:""), Impl::PropUnknown );
-    if( Impl::PropUnknown == kid ) return;
+    const int kid = qboard::propertyID( pname );
+    switch( kid )
+    {
+      case qboard::PropAlpha:
+      case qboard::PropColor:
+      case qboard::PropPos:
+      case qboard::PropZLevel:
+	  break;
+      default: // scale, angle and dragDisabled are not (yet?) supported for hiders
+	  return;
+    }
 
     // FIXME: treat QVariant::Invalid appropriately for each property
     if(0) qDebug() << "QGIDot::propertySet("<<pname<<") val="<<var;
-    if( Impl::PropZLevel == kid )
+    if( qboard::PropZLevel == kid )
     {
 	this->setZValue(var.toDouble());
+	QBoardScene::invalidateZOrder( this );
 	this->update();
 	return;
     }
-    if( Impl::PropPos == kid )
+    if( qboard::PropPos == kid )
     {
 	this->setPos( var.value<QPointF>() );
 	this->update();
 	return;
     }
-    if( (Impl::PropScale == kid) || (Impl::PropAngle == kid) )
+    if( (qboard::PropScale == kid) || (qboard::PropAngle == kid) )
     {
 	this->refreshTransformation();
 	return;
     }
-    if( Impl::PropColor == kid )
+    if( qboard::PropColor == kid )
     {
 	QBrush br( this->brush() );
 	QColor old( br.color() );
@@ -127,7 +114,7 @@ void QGIHider::propertySet( char const *pname, QVariant const & var )
 	this->update();
 	return;
     }
-    if( Impl::PropAlpha == kid )
+    if( qboard::PropAlpha == kid )
     {
 	qreal a = var.toDouble();
 	QBrush br = this->brush();
@@ -145,7 +132,7 @@ void QGIHider::propertySet( char const *pname, QVariant const & var )
     	this->update();
 	return;
     }
-    if( Impl::PropDragDisabled == kid )
+    if( qboard::PropDragDisabled == kid )
     {
 	if( var.isValid() )
 	{
@@ -261,6 +248,30 @@ bool QGIHider::deserialize( S11nNode const & src )
     return true;
 }
 
+Serializable * QGIHider::clone() const
+{
+    Serializable const * s = impl->item
+	? dynamic_cast<Serializable const *>( impl->item )
+	: 0;
+    if( impl->item && ! s ) return this->Serializable::clone(); // throws
+    std::auto_ptr<QGIHider> cl( new QGIHider );
+    cl->setPos( this->pos() );
+    if( ! s ) return cl.release();
+    Serializable * ch = s->clone();
+    QGraphicsItem * it = dynamic_cast<QGraphicsItem*>( ch );
+    if( ! it )
+    {
+	if( ch ) s11n::cleanup_serializable( ch );
+	return this->Serializable::clone();
+    }
+    cl->hideItem( it );
+    cl->setPos( this->pos() );
+    cl->setBrush( this->brush() );
+    cl->setTransform( this->transform() );
+    cl->setProperty( "zLevel", this->zValue() );
+    return cl.release();
+}
+
 
 void QGIHider::hideItem( QGraphicsItem * toHide )
 {
@@ -296,6 +307,7 @@ void QGIHider::hideItem( QGraphicsItem * toHide )
 	if( sc )
 	{
 	    //qDebug() << "QGIHider::hideItem("<<toHide<<") removing toHide from scene.";
+	    QBoardScene::invalidateZOrder( toHide );
 	    sc->removeItem(toHide);
 	}
 	toHide->setParentItem(this);
@@ -364,6 +376,7 @@ QGraphicsItem * QGIHider::unhideItem()
     it->setZValue( this->zValue() );
     QGraphicsItem * par = this->parentItem();
     QGraphicsScene * sc = this->scene();
+    QBoardScene::invalidateZOrder( this );
     if( sc && !par )
     {
 	//qDebug() << "QGIHider::unhideItem("<<it<<") adding item to scene.";
@@ -12,6 +12,7 @@
  */
 
 #include <qboard/QGIHtml.h>
+#include <qboard/PropertyID.h>
 #include <qboard/S11nQt.h>
 #include <qboard/S11nQt/QList.h>
 #include <qboard/S11nQt/QByteArray.h>
@@ -21,6 +22,7 @@
 #include <qboard/S11nQt/QString.h>
 #include <qboard/utility.h>
 #include <qboard/MenuHandlerGeneric.h>
+#include <qboard/QBoardScene.h>
 #include <qboard/S11nQt/S11nClipboard.h>
 
 #include <QGraphicsSceneMouseEvent>
@@ -30,6 +32,9 @@
 #include <QAction>
 #include <QKeySequence>
 #include <QFont>
+#include <QTextDocument>
+
+#include <memory>
 
 Q_DECLARE_METATYPE(QGIHtml*)
 
@@ -78,42 +83,32 @@ void QGIHtml::refreshTransformation()
 
 bool QGIHtml::event( QEvent * e )
 {
-    typedef QMap<QString,bool> PropMarkMap;
-    static PropMarkMap map;
-    if( map.isEmpty() )
-    {
-	map["pos"] = 1;
-	map["html"] = 1;
-	map["angle"] = 1;
-	map["scale"] = 1;
-	map["zLevel"] = 1;
-    }
     while( e->type() == QEvent::DynamicPropertyChange )
     {
 	QDynamicPropertyChangeEvent *chev = dynamic_cast<QDynamicPropertyChangeEvent *>(e);
 	if( ! chev ) break; 
 	QByteArray bakey( chev->propertyName() );
-	const QString key( bakey );
-	if(0) qDebug() << "QGIHtml::event(): DynamicPropertyChange: propery key ="<<key;
-	if( ! map.contains(key) ) break;
+	if(0) qDebug() << "QGIHtml::event(): DynamicPropertyChange: propery key ="<<bakey;
+	const int kid = qboard::propertyID( bakey );
+	if( qboard::PropUnknown == kid ) break;
 	char const * ckey = bakey.constData();
-	QVariant val( this->property(ckey) );
-	if( QString("pos") == key )
+	if( qboard::PropPos == kid )
 	{
-	    this->setPos( val.toPoint() );
+	    this->setPos( this->property(ckey).toPoint() );
 	}
-	else if( QString("html") == key )
+	else if( qboard::PropHtml == kid )
 	{
-	    this->setHtml( val.toString() );
+	    this->setHtml( this->property(ckey).toString() );
 	}
-	else if( (QString("angle") == key)
-		 || (QString("scale") == key) )
+	else if( (qboard::PropAngle == kid)
+		 || (qboard::PropScale == kid) )
 	{
 	    this->refreshTransformation();
 	}
-	else if( QString("zLevel") == key )
+	else if( qboard::PropZLevel == kid )
 	{
-	    this->setZValue( val.toDouble() );
+	    this->setZValue( this->property(ckey).toDouble() );
+	    QBoardScene::invalidateZOrder( this );
 	}
 	else
 	{
@@ -296,6 +291,28 @@ bool QGIHtml::deserialize(  S11nNode const & src )
 	return true;
 }
 
+Serializable * QGIHtml::clone() const
+{
+	std::auto_ptr<QGIHtml> cl( new QGIHtml );
+	cl->setProperty( "pos", this->pos() );
+	cl->setDocument( this->document()->clone( cl.get() ) );
+	cl->setProperty( "angle", this->property("angle").toDouble() );
+	double dbl = this->property("scale").toDouble();
+	if( dbl == 0.0 ) dbl = 1.0;
+	cl->setProperty( "scale", QVariant(dbl) );
+	cl->setZValue( this->zValue() );
+	QList<QGraphicsItem *> chgi( qboard::childItems(this) );
+	if( ! chgi.isEmpty() )
+	{
+	    QList<QGraphicsItem *> childs;
+	    if( -1 == s11n::qt::cloneQGIList<Serializable>( chgi, childs, cl.get() ) )
+	    {
+		return this->Serializable::clone();
+	    }
+	}
+	return cl.release();
+}
+
 void QGIHtml::contextMenuEvent( QGraphicsSceneContextMenuEvent * event )
 {
     MenuHandlerQGIHtml mh;
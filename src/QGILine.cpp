@@ -12,6 +12,7 @@
  */
 
 #include <qboard/QGILine.h>
+#include <qboard/LineStyle.h>
 #include <qboard/S11nQt.h>
 #include <qboard/utility.h>
 #include <qboard/MenuHandlerGeneric.h>
@@ -44,11 +45,18 @@ struct QGILineBinder::Impl
 	PointPair pts;
 	bool blockUpdates;
 	bool destructing;
+	/**
+	   Typed copies of our appearance properties, refreshed in
+	   event() so that paint() and boundingRect() need not look
+	   them up by name.
+	*/
+	qboard::LineStyle style;
 	Impl() :
 		ends(0,0),
 		pts(),
 		blockUpdates(false),
-		destructing(false)
+		destructing(false),
+		style( QColor(Qt::black), 2, Qt::SolidLine, defaultArrowSize )
 	{
 		
 	}
@@ -117,11 +125,7 @@ void QGILineBinder::mousePressEvent(QGraphicsSceneMouseEvent * ev)
 	if( (ev->buttons() & Qt::LeftButton) )
 	{
 		ev->accept();
-		qreal zV = qboard::nextZLevel(this);
-		if( zV > this->zValue() )
-		{
-			this->setZValue(zV);
-		}
+		QGITypes::raiseItem( this );
 	}
 	this->QGraphicsItem::mousePressEvent(ev);
 	impl->blockUpdates = true;
@@ -252,7 +256,14 @@ bool QGILineBinder::event( QEvent * e )
 	if( QEvent::DynamicPropertyChange == e->type() )
 	{
 		e->accept();
-		this->update();
+		QDynamicPropertyChangeEvent *chev = dynamic_cast<QDynamicPropertyChangeEvent *>(e);
+		if( chev )
+		{
+			char const * key = chev->propertyName().constData();
+			const int ch = impl->style.set( key, this->property(key) );
+			if( ch & qboard::LineStyle::Geometry ) this->prepareGeometryChange();
+			if( ch ) this->update();
+		}
 		return true;
 	}
 	return QObject::event(e);
@@ -280,16 +291,9 @@ void QGILineBinder::destroyLine()
 QRectF QGILineBinder::boundingRect() const
 {
 	if(!impl->ends.first || !impl->ends.second) return QRectF();
-	QVariant var;
-	qreal arrowSize(0.0);
-	if( this->property("drawArrows").toInt() )
-	{
-		var = this->property("arrowSize");
-		arrowSize = (var.isValid() ? var.toDouble() : Impl::defaultArrowSize);
-	}
-	var = this->property("width");
-	qreal penWidth = (var.isValid() ? var.toDouble() : 1.0);
-	qreal extra = (penWidth + arrowSize) / 2.0;
+	qboard::LineStyle const & st( impl->style );
+	qreal arrowSize( st.drawArrows ? st.arrowSize : 0.0 );
+	qreal extra = (st.width + arrowSize) / 2.0;
 
 	return QRectF(impl->pts.first, QSizeF(impl->pts.second.x() - impl->pts.first.x(),
 			impl->pts.second.y() - impl->pts.first.y()))
@@ -299,16 +303,11 @@ QRectF QGILineBinder::boundingRect() const
 void QGILineBinder::paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *)
 {
 	if( ! this->isValid() ) return;// schedule our own destruction here.
-	QVariant var;
 	static const double Pi = 3.14159265358979323846264338327950288419717;
 	static double TwoPi = 2.0 * Pi;
-	var = this->property("width");
-	qreal lineWidth = (var.isValid() ? var.toDouble() : 2.0);
-	var = this->property("color");
-	QColor lineColor = (var.isValid() ? var.value<QColor>() : Qt::black);
-	var = this->property("style");
-	int lineStyle = (var.isValid() ? var.toInt() : Qt::SolidLine);
-	if( Qt::NoPen == lineStyle ) lineStyle = Qt::SolidLine;
+	qboard::LineStyle const & st( impl->style );
+	const QColor lineColor( st.effectiveColor() );
+	const Qt::PenStyle lineStyle( (Qt::NoPen == st.style) ? Qt::SolidLine : st.style );
 
 
 	Qt::PenCapStyle capS(Qt::RoundCap);
@@ -316,17 +315,14 @@ void QGILineBinder::paint(QPainter *painter, const QStyleOptionGraphicsItem *, Q
 
 	// Draw the line itself
 	QLineF line(impl->pts.first, impl->pts.second);
-	var = this->property("alpha");
-	if( var.isValid() ) lineColor.setAlpha( var.toInt() ); 
 	painter->save();
-	painter->setPen(QPen(lineColor, lineWidth, Qt::PenStyle(lineStyle), capS, joinS));
+	painter->setPen(QPen(lineColor, st.width, lineStyle, capS, joinS));
 	painter->drawLine(line);
 	painter->restore();
 
-	if( this->property("drawArrows").toInt() )
+	if( st.drawArrows )
 	{
-		var = this->property("arrowSize");
-		qreal arrowSize = var.isValid() ? var.toDouble() : Impl::defaultArrowSize;
+		const qreal arrowSize = st.arrowSize;
 		// Draw the arrows if there's enough room
 		double angle = std::acos(line.dx() / line.length());
 		if (line.dy() >= 0)
@@ -395,11 +391,7 @@ void QGILineNode::mousePressEvent(QGraphicsSceneMouseEvent *ev)
 		if( p )
 		{
 			ev->accept();
-			qreal zV = qboard::nextZLevel(p);
-			if( zV > this->zValue() )
-			{
-				p->setZValue(zV);
-			}
+			QGITypes::raiseItem( p );
 		}
 	}
 	this->QGraphicsItem::mousePressEvent(ev);
@@ -14,6 +14,7 @@
 #include <QDebug>
 #include <QFont>
 #include <QGraphicsItem>
+#include <QImage>
 #include <QStringList>
 #include <cmath>
 
@@ -24,6 +25,9 @@
 #include <qboard/S11nQt/S11nClipboard.h>
 #include <qboard/MenuHandlerGeneric.h>
 #include <qboard/PropObj.h>
+#include <qboard/PixmapCache.h>
+#include <qboard/PropertyID.h>
+#include <qboard/QBoardScene.h>
 
 #include <qboard/S11nQt/QGraphicsItem.h>
 #include <qboard/S11nQt/QPointF.h>
@@ -34,46 +38,50 @@
 #include <algorithm>
 #include <cstdlib>
 #include <ctime>
+#include <memory>
 
 Q_DECLARE_METATYPE(QGIPiece*)
 
 
+/**
+   If QGIPiece_USE_PIXCACHE is true then pieces render themselves to
+   a pixmap tile once and blit that tile on each paint. Tiles live in
+   qboard::PixmapCache, keyed on everything which affects a piece's
+   appearance plus the device scale, so all identical-looking pieces
+   share a single tile.
+*/
 #define QGIPiece_USE_PIXCACHE 1
 
 struct QGIPiece::Impl
 {
     QPixmap pixmap;
 #if QGIPiece_USE_PIXCACHE
-    QPixmap pixcache;
+    /** Shared rendered tile (an implicitly shared handle into
+	PixmapCache, not a private copy). */
+    QPixmap tile;
+    /** Device scale tile was rendered for. */
+    qreal tileScale;
+    /** Scale-independent part of the tile's cache key. Empty
+	means "needs to be recalculated". */
+    QString appearanceKey;
 #endif
+    /** Average color of the rendered appearance. Invalid means
+	"needs to be recalculated". See QGIPiece::swatchColor(). */
+    QColor swatch;
     size_t countPaintCache;
     size_t countRepaint;
     qreal alpha;
     QPen pen;
     QPen penB;
     bool blocked;
-    enum PropIDs {
-    PropUnknown = 0,
-    PropAlpha,
-    PropAngle,
-    PropBorderAlpha,
-    PropBorderColor,
-    PropBorderSize,
-    PropBorderStyle,
-    PropColor,
-    PropDragDisabled,
-    PropPixmap,
-    PropPos,
-    PropScale,
-    PropSize,
-    PropZLevel,
-    PropEND
-    };
     Impl()
     {
 	blocked = false;
 	countPaintCache = countRepaint = 0;
 	alpha = 1;
+#if QGIPiece_USE_PIXCACHE
+	tileScale = 0;
+#endif
 
 	penB = QPen(QColor(Qt::black),
 		    1,
@@ -90,10 +98,148 @@ struct QGIPiece::Impl
     }
     void clearCache()
     {
+	swatch = QColor();
 #if QGIPiece_USE_PIXCACHE
-	pixcache = QPixmap();
+	tile = QPixmap();
+	appearanceKey.clear();
 #endif
     }
+    /**
+       Returns the scale factor between item and device coordinates
+       for the given painter.
+    */
+    static qreal deviceScale( QPainter const * p )
+    {
+	const QTransform t( p->worldTransform() );
+	// QTransform::determinant() is Qt 4.6+, so we do it by hand:
+	return std::sqrt( std::fabs( t.m11() * t.m22() - t.m12() * t.m21() ) );
+    }
+#if QGIPiece_USE_PIXCACHE
+    /** Smallest mip level mipScale() returns. */
+    static qreal minMipScale() { return 1.0 / 64; }
+    /**
+       Maps a device scale to the scale a tile is rendered at. At or
+       above 1:1 it is rounded up to the next quarter step, so that
+       small zoom changes don't each get their own tiles. Below 1:1
+       it is rounded up to a power of two, giving a chain of mip
+       levels which mipTile() builds from each other.
+    */
+    static qreal mipScale( qreal sc )
+    {
+	if( sc >= 1 )
+	{
+	    sc = std::ceil( sc * 4 ) / 4;
+	    return (sc > 8) ? 8 : sc;
+	}
+	qreal m = 1;
+	while( (m / 2 >= sc) && (m > minMipScale()) ) m /= 2;
+	return m;
+    }
+    /**
+       Returns the PixmapCache key for this piece's appearance,
+       rendered to the given bounds at the given device scale.
+    */
+    QString tileKey( QRectF const & bounds, qreal scale )
+    {
+	if( appearanceKey.isEmpty() )
+	{
+	    appearanceKey = QString("QGIPiece|%1|%2|%3|%4|%5|%6x%7").
+		arg(pixmap.cacheKey()).
+		arg(pen.color().rgba()).
+		arg(penB.color().rgba()).
+		arg(penB.widthF()).
+		arg(int(penB.style())).
+		arg(bounds.width()).
+		arg(bounds.height());
+	}
+	return QString("%1@%2").arg(appearanceKey).arg(scale);
+    }
+    /**
+       Returns the tile for the given bounds and mipScale() value,
+       from PixmapCache if possible. Levels below 1:1 are made by
+       halving the next bigger level instead of rendering from
+       scratch, which both looks better (every source pixel
+       contributes) and is cheaper.
+    */
+    QPixmap mipTile( QRectF const & bounds, qreal scale )
+    {
+	const QString key( tileKey( bounds, scale ) );
+	QPixmap tile;
+	if( qboard::PixmapCache::instance().find( key, tile ) )
+	{
+	    ++countPaintCache;
+	    return tile;
+	}
+	if( scale < 1 )
+	{
+	    const QPixmap up( mipTile( bounds, scale * 2 ) );
+	    tile = up.scaled( qMax( 1, (up.width() + 1) / 2 ),
+			      qMax( 1, (up.height() + 1) / 2 ),
+			      Qt::IgnoreAspectRatio,
+			      Qt::SmoothTransformation );
+	}
+	else
+	{
+	    QSize tsz( int(std::ceil(bounds.width() * scale)),
+		       int(std::ceil(bounds.height() * scale)) );
+	    if( tsz.width() < 1 ) tsz.setWidth(1);
+	    if( tsz.height() < 1 ) tsz.setHeight(1);
+	    tile = QPixmap( tsz );
+	    tile.fill( Qt::transparent );
+	    QPainter cp( &tile );
+	    cp.scale( scale, scale );
+	    cp.translate( -bounds.topLeft() );
+	    render( &cp, bounds, true );
+	}
+	qboard::PixmapCache::instance().insert( key, tile );
+	return tile;
+    }
+#endif
+    /**
+       Renders the background color, pixmap and border to cp, in
+       item coordinates. If forCache is true then some adjustments
+       are made to make up for QPixmap's int-based coordinates.
+    */
+    void render( QPainter * cp, QRectF const & bounds, bool forCache )
+    {
+	++countRepaint;
+#define AMSG if(0) qDebug() << "QGIPixmap::paint():"
+	if( 1 ) // Background color
+	{
+	    QColor col = pen.color();
+	    if( col.isValid() )
+	    {
+		cp->fillRect( bounds, col );
+	    }
+	}
+	const qreal bs = penB.widthF();
+	qreal xl = bs / 2.0;
+
+	if( ! pixmap.isNull() ) // Draw pixmap
+	{
+	    // Weird: if i use pixmap.rect() i get (0.5,0.5,W,H)
+	    QRectF pmr( QPointF(0,0), pixmap.size() );
+	    AMSG << "drawPixmap("<<pmr<<"...)";
+	    cp->drawPixmap(pmr, pixmap, pixmap.rect() );
+	}
+
+	if( bs && penB.color().isValid() ) // Draw border
+	{
+	    QRectF br( bounds );
+	    br.adjust( xl, xl, -xl, -xl );
+ 	    if( forCache && ((int(bs+0.49) % 2) == 1) )
+ 	    { // kludge to avoid some off-by-one unsightlyness
+		qreal fudge = 0.5;
+ 		br.adjust( -fudge, -fudge, -fudge, -fudge );
+ 	    }
+	    cp->save();
+	    cp->setPen( penB );
+	    AMSG << "drawRect("<<br<<"...) bs ="<<bs<<", xl ="<<xl;;
+	    cp->drawRect( br );
+	    cp->restore();
+	}
+#undef AMSG
+    }
 };
 
 #include <QGraphicsScene>
@@ -151,43 +297,21 @@ bool QGIPiece::event( QEvent * e )
 void QGIPiece::propertySet( char const *pname, QVariant const & var )
 {
     // FIXME: treat QVariant::Invalid appropriately for each property
-    typedef QMap<QString,int> PMAP;
-    static PMAP pmap;
-    if( pmap.isEmpty() )
-    {
-#define MAP(S,V) pmap[S] = Impl::V;
-	MAP("color",PropColor);
-	MAP("alpha",PropAlpha);
-	MAP("colorAlpha",PropAlpha); // older name
-	MAP("borderColor",PropBorderColor);
-	MAP("borderSize",PropBorderSize);
-	MAP("borderAlpha",PropBorderAlpha);
-	MAP("borderStyle",PropBorderStyle);
-	MAP("zLevel",PropZLevel);
-	MAP("pos",PropPos);
-	MAP("scale",PropScale);
-	MAP("size",PropSize);
-	MAP("angle",PropAngle);
-	MAP("dragDisabled",PropDragDisabled);
-	MAP("pixmap",PropPixmap);
-#undef MAP
-    }
-
-    const QString key(pname?pname:"");
-    int kid = pmap.value( key, Impl::PropUnknown );
-    if( Impl::PropUnknown == kid ) return;
-    if(0) qDebug() << "QGIPiece::propertySet("<<key<<")] val ="<<var;
-    if( Impl::PropZLevel == kid )
+    const int kid = qboard::propertyID( pname );
+    if( qboard::PropUnknown == kid ) return;
+    if(0) qDebug() << "QGIPiece::propertySet("<<pname<<")] val ="<<var;
+    if( qboard::PropZLevel == kid )
     {
 	this->setZValue(var.toDouble());
+	QBoardScene::invalidateZOrder( this );
 	this->update();
     }
-    else if( Impl::PropPos == kid )
+    else if( qboard::PropPos == kid )
     {
 	this->setPos( var.value<QPointF>() );
 	this->update();
     }
-    else if( Impl::PropColor == kid )
+    else if( qboard::PropColor == kid )
     {
  	QColor col = var.value<QColor>();
 	qreal alpha = impl->pen.color().alphaF();
@@ -207,7 +331,7 @@ void QGIPiece::propertySet( char const *pname, QVariant const & var )
 	impl->clearCache();
 	this->update();
     }
-    else if( Impl::PropAlpha == kid )
+    else if( qboard::PropAlpha == kid )
     {
 	qreal a = var.toDouble();
 	QColor col = impl->pen.color();
@@ -223,7 +347,7 @@ void QGIPiece::propertySet( char const *pname, QVariant const & var )
 	impl->clearCache();
     	this->update();
     }
-    else if( Impl::PropBorderColor == kid )
+    else if( qboard::PropBorderColor == kid )
     {
 	QColor col = var.value<QColor>();
  	if( 255 == col.alpha() )
@@ -234,7 +358,7 @@ void QGIPiece::propertySet( char const *pname, QVariant const & var )
 	impl->clearCache();
 	this->update();
     }
-    else if( Impl::PropBorderAlpha == kid )
+    else if( qboard::PropBorderAlpha == kid )
     {
 	qreal a = var.toDouble();
 	QColor col( impl->penB.color() );
@@ -250,24 +374,24 @@ void QGIPiece::propertySet( char const *pname, QVariant const & var )
 	impl->clearCache();
 	this->update();
     }
-    else if( Impl::PropBorderSize == kid )
+    else if( qboard::PropBorderSize == kid )
     {
 	double bs = var.toDouble();
 	impl->penB.setWidth( (bs >= 0) ? bs : 0 );
 	impl->clearCache();
 	this->update();
     }
-    else if( Impl::PropBorderStyle == kid )
+    else if( qboard::PropBorderStyle == kid )
     {
 	impl->clearCache();
 	impl->penB.setStyle( s11n::qt::stringToPenStyle(var.toString()) );
 	this->update();
     }
-    else if( (Impl::PropScale == kid) || (Impl::PropAngle == kid) )
+    else if( (qboard::PropScale == kid) || (qboard::PropAngle == kid) )
     {
 	this->refreshTransformation();
     }
-    else if( Impl::PropDragDisabled == kid )
+    else if( qboard::PropDragDisabled == kid )
     {
 	if( var.isValid() )
 	{
@@ -278,7 +402,7 @@ void QGIPiece::propertySet( char const *pname, QVariant const & var )
 	    this->setFlag( QGraphicsItem::ItemIsMovable, true );
 	}
     }
-    else if( Impl::PropPixmap == kid )
+    else if( qboard::PropPixmap == kid )
     {
 	this->prepareGeometryChange();
 	impl->clearCache();
@@ -290,7 +414,8 @@ void QGIPiece::propertySet( char const *pname, QVariant const & var )
 	else if( var.canConvert<QString>() )
 	{
 	    QString fname( qboard::homeRelative(var.toString()) );
-	    if( pix.load( fname ) )
+	    pix = qboard::PixmapCache::instance().load( fname );
+	    if( ! pix.isNull() )
 	    {
 		this->setProperty("size",pix.size());
 	    }
@@ -318,7 +443,7 @@ void QGIPiece::propertySet( char const *pname, QVariant const & var )
 	}
 	this->update();
     } // pixmap property
-    if( Impl::PropSize == kid )
+    if( qboard::PropSize == kid )
     {
 	impl->clearCache();
 	if( impl->pixmap.isNull() )
@@ -447,81 +572,78 @@ void QGIPiece::paint( QPainter * painter, const QStyleOptionGraphicsItem * optio
        but it causes rounding errors because QPixmap is int-based.
        The borders don't show up properly (off-by-one errors) at certain
        sizes and scales.
-    */
 
+       The tile is rendered at the current device scale (i.e. the
+       view's zoom level combined with our own transformation), so
+       zoomed-in views get a full-resolution tile instead of a blown-up
+       low-res one. Zoomed-out views get a pre-downsampled mip level
+       (see Impl::mipScale()), and pieces smaller than LodSwatchPixels
+       are just a rectangle of their swatchColor().
+    */
     QRectF bounds( this->boundingRect().normalized() );
-#define AMSG if(0) qDebug() << "QGIPixmap::paint():"
-    if( 
-#if QGIPiece_USE_PIXCACHE
-       impl->pixcache.isNull()
-#else
-       1
-#endif
-       )
-    {
-	++impl->countRepaint;
-	QPainter * cp = 0;
-#if QGIPiece_USE_PIXCACHE
-	QPixmap captcha( bounds.size().toSize() );
-	AMSG << "bounds="<<bounds<<", pixcache.size ="<<captcha.size();
-	captcha.fill( Qt::transparent );
-	QPainter _cp( &captcha );
-	cp = &_cp;
-#else
-	cp = painter;
-#endif
-	if( 1 ) // Background color
+    const qreal lod = Impl::deviceScale( painter );
+    if( (qMax( bounds.width(), bounds.height() ) * lod) < LodSwatchPixels )
+    { // Too small to show any detail. (QBoardScene may have replaced
+	// whole stacks of such pieces with a single glyph already.)
+	painter->fillRect( bounds, this->swatchColor() );
+	if( this->isSelected() )
 	{
-	    QColor col = impl->pen.color();
-	    if( col.isValid() )
-	    {
-		cp->fillRect( bounds, col );
-	    }
-	}
-	const qreal bs = impl->penB.widthF();
-	qreal xl = bs / 2.0;
-
-	if( ! impl->pixmap.isNull() ) // Draw pixmap
-	{
-	    // Weird: if i use impl->pixmap.rect() i get (0.5,0.5,W,H)
-	    QRectF pmr( QPointF(0,0), impl->pixmap.size() );
-	    //QRectF pmr( impl->pixmap.rect() );
-	    AMSG << "drawPixmap("<<pmr<<"...)";
-	    cp->drawPixmap(pmr, impl->pixmap, impl->pixmap.rect() );
-	}
-
-	if( bs && impl->penB.color().isValid() ) // Draw border
-	{
-	    QRectF br( bounds );
-	    br.adjust( xl, xl, -xl, -xl );
-#if QGIPiece_USE_PIXCACHE
- 	    if( (int(bs+0.49) % 2) == 1 )
- 	    { // kludge to avoid some off-by-one unsightlyness
-		qreal fudge = 0.5;
- 		br.adjust( -fudge, -fudge, -fudge, -fudge );
- 	    }
-#endif
-	    cp->save();
-	    cp->setPen( impl->penB );
-	    AMSG << "drawRect("<<br<<"...) bs ="<<bs<<", xl ="<<xl;;
-	    cp->drawRect( br );
-	    cp->restore();
+	    this->QGraphicsPixmapItem::paint(painter,option,widget);
 	}
+	return;
+    }
 #if QGIPiece_USE_PIXCACHE
-	impl->pixcache = captcha;
-#endif
+    const qreal scale = Impl::mipScale( lod );
+    if( impl->tile.isNull() || (scale != impl->tileScale) )
+    {
+	impl->tile = impl->mipTile( bounds, scale );
+	impl->tileScale = scale;
     }
     else
     {
 	++impl->countPaintCache;
-	if(0) AMSG << "using cached image.";
     }
-#if QGIPiece_USE_PIXCACHE
-    painter->drawPixmap( bounds, impl->pixcache, bounds );
+    painter->drawPixmap( bounds, impl->tile, QRectF( impl->tile.rect() ) );
+#else
+    impl->render( painter, bounds, false );
 #endif
     // Let parent draw selection borders and such:
     this->QGraphicsPixmapItem::paint(painter,option,widget);
-#undef AMSG
+}
+
+QColor QGIPiece::swatchColor() const
+{
+    if( impl->swatch.isValid() ) return impl->swatch;
+    const int side = 16;
+    QImage img( side, side, QImage::Format_ARGB32_Premultiplied );
+    img.fill( 0 );
+    const QRectF bounds( this->boundingRect().normalized() );
+    if( (bounds.width() > 0) && (bounds.height() > 0) )
+    {
+	QPainter p( &img );
+	p.setRenderHint( QPainter::SmoothPixmapTransform, true );
+	p.scale( side / bounds.width(), side / bounds.height() );
+	p.translate( -bounds.topLeft() );
+	impl->render( &p, bounds, false );
+    }
+    // Average the premultiplied pixels, so that transparent parts
+    // don't darken the result.
+    quint64 r = 0, g = 0, b = 0, a = 0;
+    for( int y = 0; y < side; ++y )
+    {
+	QRgb const * line = reinterpret_cast<QRgb const *>( img.scanLine(y) );
+	for( int x = 0; x < side; ++x )
+	{
+	    r += qRed( line[x] );
+	    g += qGreen( line[x] );
+	    b += qBlue( line[x] );
+	    a += qAlpha( line[x] );
+	}
+    }
+    impl->swatch = a
+	? QColor( int(r * 255 / a), int(g * 255 / a), int(b * 255 / a), int(a / (side * side)) )
+	: QColor( Qt::transparent );
+    return impl->swatch;
 }
 
 #include <QGraphicsSceneDragDropEvent>
@@ -648,6 +770,35 @@ bool QGIPiece::deserialize( S11nNode const & src )
     return true;
 }
 
+Serializable * QGIPiece::clone() const
+{
+    std::auto_ptr<QGIPiece> cl( new QGIPiece );
+    QList<QGraphicsItem *> chgi( qboard::childItems(this) );
+    if( ! chgi.isEmpty() )
+    {
+	QList<QGraphicsItem *> childs;
+	if( -1 == s11n::qt::cloneQGIList<Serializable>( chgi, childs, cl.get() ) )
+	{
+	    return this->Serializable::clone();
+	}
+    }
+    cl->setTransform( this->transform() );
+    cl->impl->pen = impl->pen;
+    cl->impl->penB = impl->penB;
+    char const * keys[] = { "size", "pixmap", 0 };
+    for( char const ** k = keys; *k; ++k )
+    {
+	QVariant v( this->property(*k) );
+	if( v.isValid() ) cl->setProperty( *k, v );
+    }
+    cl->setProperty( "pos", this->pos() );
+    cl->setProperty( "zLevel", this->zValue() );
+    cl->impl->blocked = true;
+    cl->setProperty( "color", impl->pen.color() );
+    cl->impl->blocked = false;
+    return cl.release();
+}
+
 #include <qboard/QGIHider.h>
 QGraphicsItem * QGIPiece::hideItems()
 {
@@ -727,6 +878,7 @@ bool QGIPieceMenuHandler::cutPiece()
 {
     if( this->copyPiece() )
     {
+	QBoardScene::invalidateZOrder( impl->piece );
 	impl->piece->deleteLater();
     }
     return false;
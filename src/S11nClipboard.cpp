@@ -15,11 +15,61 @@
 #include <sstream>
 #include <QClipboard>
 #include <QApplication>
+#include <QMimeData>
+#include <QStringList>
 
 #ifndef Q_EMIT
 #  define Q_EMIT
 #endif
 
+char const * S11nClipboard::MimeType = "application/x-s11n";
+
+/**
+   The QMimeData S11nClipboard gives to QClipboard. It only serializes
+   the clipboard content when another application requests it, and
+   lets S11nClipboard recognize its own data.
+*/
+class S11nClipboardMimeData : public QMimeData
+{
+public:
+    S11nClipboard const * owner;
+    explicit S11nClipboardMimeData( S11nClipboard const * o,
+				    S11nClipboard::S11nNode const * n )
+	: QMimeData(), owner(o), node(n), bytes(), done(false)
+    {
+    }
+    virtual QStringList formats() const
+    {
+	return QStringList() << S11nClipboard::MimeType << "text/plain";
+    }
+    virtual bool hasFormat( QString const & mimetype ) const
+    {
+	return this->formats().contains( mimetype );
+    }
+protected:
+    virtual QVariant retrieveData( QString const & mimetype, QVariant::Type type ) const
+    {
+	if( ! this->hasFormat( mimetype ) ) return this->QMimeData::retrieveData( mimetype, type );
+	if( ! done )
+	{
+	    done = true;
+	    std::ostringstream os;
+	    if( node && s11nlite::save( *node, os ) )
+	    {
+		std::string const & str( os.str() );
+		bytes = QByteArray( str.data(), int(str.size()) );
+	    }
+	    if(0) qDebug() << "S11nClipboardMimeData serialized"<<bytes.size()<<"bytes on request for"<<mimetype;
+	}
+	return bytes;
+    }
+private:
+    /** The S11nClipboard's node. Replacing that also replaces this object. */
+    S11nClipboard::S11nNode const * node;
+    mutable QByteArray bytes;
+    mutable bool done;
+};
+
 S11nClipboard::S11nClipboard() : m_node(0)
 {
     this->syncFromQt();
@@ -46,11 +96,8 @@ void S11nClipboard::syncToQt()
     // cb->clear(); doh! Ends up nuking m_node via signal to syncFromQt()!
     if( this->m_node )
     {
-	std::ostringstream os;
-	if( s11nlite::save( *m_node, os ) )
-	{
-	    cb->setText( os.str().c_str() );
-	}
+	// Serialization is deferred until someone asks for the data.
+	cb->setMimeData( new S11nClipboardMimeData( this, this->m_node ) );
     }
     else
     {
@@ -62,9 +109,21 @@ void S11nClipboard::syncToQt()
 
 void S11nClipboard::syncFromQt()
 {
-    QString data( QApplication::clipboard()->text( QClipboard::Clipboard ) );
+    QMimeData const * md = QApplication::clipboard()->mimeData( QClipboard::Clipboard );
+    S11nClipboardMimeData const * mine = dynamic_cast<S11nClipboardMimeData const *>( md );
+    if( mine && (mine->owner == this) )
+    { // We published this data, so m_node is already what it holds.
+	return;
+    }
     delete m_node;
     m_node = 0;
+    QByteArray data;
+    if( md )
+    {
+	data = md->hasFormat( MimeType )
+	    ? md->data( MimeType )
+	    : md->text().toUtf8();
+    }
     if( data.isEmpty() )
     {
 	Q_EMIT signalUpdated();
@@ -72,8 +131,7 @@ void S11nClipboard::syncFromQt()
     }
     S11nNode * node = 0;
     {
-	char const * ascii = data.toAscii().data();
-	std::istringstream buf(ascii ? ascii : "");
+	std::istringstream buf( std::string( data.constData(), data.size() ) );
 	node = s11nlite::load_node( buf );
     }
     m_node = node;
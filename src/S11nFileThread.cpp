@@ -0,0 +1,229 @@
+/*
+ * This file is (or was, at some point) part of the QBoard project
+ * (http://code.google.com/p/qboard)
+ *
+ * Copyright (c) 2008 Stephan Beal (http://wanderinghorse.net/home/stephan/)
+ *
+ * This file may be used under the terms of the GNU General Public
+ * License versions 2.0 or 3.0 as published by the Free Software
+ * Foundation and appearing in the files LICENSE.GPL2 and LICENSE.GPL3
+ * included in the packaging of this file.
+ *
+ */
+
+#include <QAtomicInt>
+#include <QDebug>
+#include <QFile>
+
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+
+#if defined(Q_OS_WIN)
+#  include <windows.h>
+#endif
+
+#include <qboard/S11nFileThread.h>
+#include <qboard/S11nQt/Stream.h>
+#include <s11n.net/zfstream/zfstream.hpp>
+
+struct S11nFileThread::Impl
+{
+    S11nFileThread::Mode mode;
+    QString fileName;
+    S11nNode * node;
+    /**
+       The serializer for the job. It is created (via s11nlite's
+       classloader and current serializer class, neither of which
+       is thread-safe) by the constructors, i.e. on the client's
+       thread. Parsing itself is guarded by s11n::io::parse_lock.
+    */
+    s11nlite::serializer_interface * ser;
+    QString error;
+    QAtomicInt cancelled;
+    Impl( S11nFileThread::Mode m, QString const & fn, S11nNode * n ) :
+	mode(m),
+	fileName(fn),
+	node(n),
+	ser(0),
+	error(),
+	cancelled(0)
+    {
+    }
+    ~Impl()
+    {
+	delete node;
+	delete ser;
+    }
+    /**
+       Moves the file named from over the file named to, replacing
+       it atomically where the platform allows. On failure both
+       files are left as they were.
+    */
+    static bool replaceFile( QString const & from, QString const & to )
+    {
+#if defined(Q_OS_WIN)
+	return 0 != ::MoveFileExW( reinterpret_cast<wchar_t const *>(from.utf16()),
+				   reinterpret_cast<wchar_t const *>(to.utf16()),
+				   MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH );
+#else
+	// rename(2) replaces an existing target atomically.
+	return 0 == std::rename( QFile::encodeName(from).constData(),
+				 QFile::encodeName(to).constData() );
+#endif
+    }
+};
+
+S11nFileThread::S11nFileThread( QString const & fn ) :
+    QThread(),
+    impl(new Impl(Load,fn,0))
+{
+    try
+    {
+	impl->ser = s11n::qt::serializerFor( fn );
+    }
+    catch(...)
+    { // runLoad() reports it.
+	impl->ser = 0;
+    }
+}
+
+S11nFileThread::S11nFileThread( QString const & fn, S11nNode * root ) :
+    QThread(),
+    impl(new Impl(Save,fn,root))
+{
+    impl->ser = s11nlite::create_serializer();
+}
+
+S11nFileThread::~S11nFileThread()
+{
+    this->cancel();
+    this->wait();
+    delete impl;
+}
+
+S11nFileThread::Mode S11nFileThread::mode() const
+{
+    return impl->mode;
+}
+
+QString S11nFileThread::fileName() const
+{
+    return impl->fileName;
+}
+
+S11nNode * S11nFileThread::takeNode()
+{
+    if( (Load != impl->mode) || this->isRunning() || this->wasCancelled() ) return 0;
+    S11nNode * n = impl->node;
+    impl->node = 0;
+    return n;
+}
+
+QString S11nFileThread::errorString() const
+{
+    return impl->error;
+}
+
+void S11nFileThread::cancel()
+{
+    impl->cancelled = 1;
+}
+
+bool S11nFileThread::wasCancelled() const
+{
+    return 0 != impl->cancelled;
+}
+
+bool S11nFileThread::runLoad()
+{
+    if( ! impl->ser )
+    {
+	impl->error = QString("Could not open file [%1], or its format is unknown.").arg(impl->fileName);
+	return false;
+    }
+    std::auto_ptr<S11nNode> np( s11n::qt::loadNode( impl->fileName, impl->ser ) );
+    if( ! np.get() )
+    {
+	impl->error = QString("Could not parse file [%1].").arg(impl->fileName);
+	return false;
+    }
+    if( this->wasCancelled() ) return false;
+    impl->node = np.release();
+    return true;
+}
+
+bool S11nFileThread::runSave()
+{
+    if( ! impl->node )
+    {
+	impl->error = "S11nFileThread: no data to save.";
+	return false;
+    }
+    if( ! impl->ser )
+    {
+	impl->error = "S11nFileThread: could not create the serializer.";
+	return false;
+    }
+    const QString tmp( impl->fileName + ".part" );
+    bool ok = false;
+    {
+	QFile f( tmp );
+	if( f.open( QIODevice::WriteOnly | QIODevice::Unbuffered ) )
+	{
+	    s11n::qt::QtStdOStream os( f );
+	    {
+		// Compresses (in parallel) if zfstream::compression_policy()
+		// asks for it. Deleting zos finishes the compressed data.
+		std::auto_ptr<std::ostream> zos( zfstream::get_ostream( os ) );
+		ok = impl->ser->serialize( *impl->node, zos.get() ? *zos : os );
+	    }
+	    ok = ok && os.flush().good();
+	}
+    }
+    delete impl->node;
+    impl->node = 0;
+    if( ok && ! this->wasCancelled() )
+    {
+	if( ! Impl::replaceFile( tmp, impl->fileName ) )
+	{
+	    // Keep tmp: it may be the only complete copy of the data.
+	    impl->error = QString("Could not rename [%1] to [%2]. The saved data were left in [%1].").
+		arg(tmp).arg(impl->fileName);
+	    return false;
+	}
+	return true;
+    }
+    if( ! ok )
+    {
+	impl->error = QString("Could not write file [%1].").arg(tmp);
+    }
+    QFile::remove( tmp );
+    return false;
+}
+
+void S11nFileThread::run()
+{
+    bool ok = false;
+    try
+    {
+	ok = (Load == impl->mode) ? this->runLoad() : this->runSave();
+    }
+    catch( std::exception const & ex )
+    {
+	impl->error = ex.what();
+	ok = false;
+    }
+    catch(...)
+    {
+	impl->error = "S11nFileThread: unknown exception.";
+	ok = false;
+    }
+    if( this->wasCancelled() )
+    {
+	ok = false;
+	if( impl->error.isEmpty() ) impl->error = "Cancelled.";
+    }
+    if(0) qDebug() << "S11nFileThread::run()"<<impl->fileName<<"ok ="<<ok<<impl->error;
+    Q_EMIT jobDone( ok );
+}
@@ -14,10 +14,12 @@
 #include <QChar>
 #include <QBuffer>
 #include <QDebug>
+#include <QHash>
 #include <QMap>
 
 #include <qboard/S11nQt.h>
 #include <s11n.net/s11n/functional.hpp>
+#include <s11n.net/s11n/blob.hpp>
 
 #include <qboard/S11nQt/QBitArray.h>
 #include <qboard/S11nQt/QBrush.h>
@@ -281,24 +283,59 @@ static hashval_t hash_cstring_djb2( void const * vstr)
 }
 
 unsigned long QByteArray_s11n::compressionThreshold = 100;
+
+/**
+   Stores src (compressed if zIt is true) in dest's "data" blob.
+   The "z" flag tells the deserializer whether to uncompress it,
+   so that data which is already compressed (e.g. PNG) need not
+   go through qCompress().
+*/
+static void serializeBytes( S11nNode & dest, QByteArray const & src, bool zIt )
+{
+    typedef s11nlite::node_traits NT;
+    NT::set( dest, "z", zIt ? 1 : 0 );
+    if( zIt )
+    {
+	QByteArray const z( qCompress(src) );
+	NT::blobs( dest )["data"].assign( z.constData(), std::size_t(z.size()) );
+    }
+    else
+    {
+	NT::blobs( dest )["data"].assign( src.constData(), std::size_t(src.size()) );
+    }
+}
+
 bool QByteArray_s11n::operator()( S11nNode & dest, QByteArray const & src ) const
 {
     if( src.isEmpty() ) return true;
-    typedef s11nlite::node_traits NT;
     bool zIt = QByteArray_s11n::compressionThreshold
 	? ((((unsigned long)src.size()) > QByteArray_s11n::compressionThreshold) ? true : false)
 	: false;
-    QByteArray b64( QByteArray( zIt
-				? qCompress(src)
-				: src ).toBase64() );
-    b64.append('\0');
-    NT::set( dest, "djb2", hash_cstring_djb2( b64.constData() ) );
-    NT::set( dest, "bin64", std::string( b64.constData(), b64.size()-1 ) );
+    serializeBytes( dest, src, zIt );
     return true;
 }
 bool QByteArray_s11n::operator()( S11nNode const & src, QByteArray & dest ) const
 {
 	typedef s11nlite::node_traits NT;
+	NT::blob_map_type::const_iterator bit = NT::blobs( src ).find( "data" );
+	if( NT::blobs( src ).end() != bit )
+	{
+	    std::string const & data( (*bit).second.data() );
+	    if( NT::get( src, "z", 0 ) )
+	    {
+		dest = qUncompress( reinterpret_cast<uchar const *>( data.data() ), int(data.size()) );
+		if( dest.isEmpty() && ! data.empty() )
+		{
+		    throw s11n::s11n_exception("QByteArray deserialize failed: could not uncompress the data.");
+		}
+	    }
+	    else
+	    {
+		dest = QByteArray( data.data(), int(data.size()) );
+	    }
+	    return true;
+	}
+	// Older files hold base64 text with a djb2 checksum:
 	QByteArray tmp;
 	{
 	    std::string data( NT::get( src, "bin64", std::string() ) );
@@ -588,22 +625,62 @@ bool QPen_s11n::operator()( S11nNode const & src, QPen & dest ) const
     return true;
 }
 
+/**
+   Encodes px as PNG data. A null pixmap gives empty data.
+*/
+static bool encodePixmap( QPixmap const & px, QByteArray & ba )
+{
+    ba.clear();
+    if( px.isNull() ) return true;
+    QBuffer buf(&ba);
+    return px.save( &buf, "PNG" );
+}
+
+/**
+   Stores the encoded image data ba in a "bytes" child of dest,
+   in a form QByteArray_s11n can read back.
+*/
+static bool serializePixmapBytes( S11nNode & dest, QByteArray const & ba )
+{
+	// PNG data is already compressed, so store it without
+	// letting QByteArray_s11n qCompress() it again.
+	typedef s11nlite::node_traits NT;
+	std::auto_ptr<S11nNode> ch( NT::create( "bytes" ) );
+	NT::class_name( *ch, s11n::s11n_traits<QByteArray>::class_name(&ba) );
+	if( ! ba.isEmpty() ) serializeBytes( *ch, ba, false );
+	NT::children( dest ).push_back( ch.release() );
+	return true;
+}
+
 bool QPixmap_s11n::operator()( S11nNode & dest, QPixmap const & src ) const
 {
-	QByteArray ba;
-	if( ! src.isNull() )
+	QPixmapTable * tbl = src.isNull() ? 0 : QPixmapTable::current();
+	if( tbl )
 	{
-	    QBuffer buf(&ba);
-	    if( ! src.save( &buf, "PNG" ) )
-	    {
-		return false;
-	    }
+	    std::string const id( tbl->add( src ) );
+	    if( id.empty() ) return false;
+	    S11nNodeTraits::set( dest, "ref", id );
+	    return true;
 	}
-	return s11n::serialize_subnode( dest, "bytes", ba );
+	QByteArray ba;
+	if( ! encodePixmap( src, ba ) ) return false;
+	return serializePixmapBytes( dest, ba );
 }
 bool QPixmap_s11n::operator()( S11nNode const & src, QPixmap & dest ) const
 {
     dest = QPixmap();
+    std::string const ref( S11nNodeTraits::get( src, "ref", std::string() ) );
+    if( ! ref.empty() )
+    {
+	QPixmapTable * tbl = QPixmapTable::current();
+	if( ! tbl )
+	{
+	    qDebug() << "QPixmap_s11n: no QPixmapTable is current to resolve ref" << ref.c_str();
+	    return false;
+	}
+	dest = tbl->lookup( ref );
+	return ! dest.isNull();
+    }
     QByteArray ba;
     if( ! s11n::deserialize_subnode( src, "bytes", ba ) )
     {
@@ -612,6 +689,156 @@ bool QPixmap_s11n::operator()( S11nNode const & src, QPixmap & dest ) const
     return dest.loadFromData( ba );
 }
 
+struct QPixmapTable::Impl
+{
+    struct Entry
+    {
+	std::string id;
+	/** Encoded data. Dropped once the image is decoded on load. */
+	QByteArray bytes;
+	QPixmap pixmap;
+    };
+    QList<Entry> entries;
+    /** id to index in entries. */
+    QHash<QString,int> ids;
+    /** QPixmap::cacheKey() to index, so shared pixmaps are encoded only once. */
+    QHash<qint64,int> keys;
+    /** crc32c of the encoded data to indexes, for content lookups. */
+    QMultiHash<quint32,int> crcs;
+    static QPixmapTable * current;
+};
+QPixmapTable * QPixmapTable::Impl::current = 0;
+
+QPixmapTable::QPixmapTable()
+    : impl(new Impl)
+{
+}
+QPixmapTable::~QPixmapTable()
+{
+    if( Impl::current == this ) Impl::current = 0;
+    delete impl;
+}
+
+std::string QPixmapTable::add( QPixmap const & px )
+{
+    const qint64 key = px.cacheKey();
+    QHash<qint64,int>::const_iterator kit = impl->keys.constFind( key );
+    if( impl->keys.constEnd() != kit ) return impl->entries[kit.value()].id;
+    QByteArray ba;
+    if( ! encodePixmap( px, ba ) ) return std::string();
+    const quint32 crc = quint32( s11n::crc32c( ba.constData(), ba.size() ) );
+    QMultiHash<quint32,int>::const_iterator it = impl->crcs.constFind( crc );
+    for( ; impl->crcs.constEnd() != it && it.key() == crc; ++it )
+    {
+	if( impl->entries[it.value()].bytes == ba )
+	{
+	    impl->keys.insert( key, it.value() );
+	    return impl->entries[it.value()].id;
+	}
+    }
+    // Ids are the checksum and size of the data, plus a suffix in
+    // the unlikely case of a collision, so they are stable across
+    // saves of the same images.
+    QString id = QString("%1-%2").arg(crc,8,16,QChar('0')).arg(ba.size());
+    for( int i = 2; impl->ids.contains( id ); ++i )
+    {
+	id = QString("%1-%2-%3").arg(crc,8,16,QChar('0')).arg(ba.size()).arg(i);
+    }
+    Impl::Entry e;
+    e.id = id.toAscii().constData();
+    e.bytes = ba;
+    const int ndx = impl->entries.size();
+    impl->entries.append( e );
+    impl->ids.insert( id, ndx );
+    impl->keys.insert( key, ndx );
+    impl->crcs.insert( crc, ndx );
+    return e.id;
+}
+
+QPixmap QPixmapTable::lookup( std::string const & id )
+{
+    QHash<QString,int>::const_iterator it = impl->ids.constFind( QString::fromAscii( id.c_str() ) );
+    if( impl->ids.constEnd() == it ) return QPixmap();
+    Impl::Entry & e( impl->entries[it.value()] );
+    if( e.pixmap.isNull() && ! e.bytes.isEmpty() )
+    {
+	if( e.pixmap.loadFromData( e.bytes ) )
+	{
+	    e.bytes = QByteArray();
+	}
+    }
+    return e.pixmap;
+}
+
+int QPixmapTable::count() const
+{
+    return impl->entries.size();
+}
+
+void QPixmapTable::clear()
+{
+    impl->entries.clear();
+    impl->ids.clear();
+    impl->keys.clear();
+    impl->crcs.clear();
+}
+
+bool QPixmapTable::serialize( S11nNode & dest ) const
+{
+    typedef S11nNodeTraits NT;
+    NT::class_name( dest, "QPixmapTable" );
+    for( int i = 0; i < impl->entries.size(); ++i )
+    {
+	Impl::Entry const & e( impl->entries[i] );
+	std::auto_ptr<S11nNode> ch( NT::create( "pixmap" ) );
+	NT::set( *ch, "id", e.id );
+	if( ! serializePixmapBytes( *ch, e.bytes ) ) return false;
+	NT::children( dest ).push_back( ch.release() );
+    }
+    return true;
+}
+
+bool QPixmapTable::deserialize( S11nNode const & src )
+{
+    typedef S11nNodeTraits NT;
+    this->clear();
+    NT::child_list_type const & chs( NT::children( src ) );
+    NT::child_list_type::const_iterator it = chs.begin();
+    for( ; chs.end() != it; ++it )
+    {
+	S11nNode const & ch( **it );
+	Impl::Entry e;
+	e.id = NT::get( ch, "id", std::string() );
+	if( e.id.empty() ) continue;
+	if( ! s11n::deserialize_subnode( ch, "bytes", e.bytes ) ) return false;
+	const QString id( QString::fromAscii( e.id.c_str() ) );
+	if( impl->ids.contains( id ) ) continue;
+	impl->ids.insert( id, impl->entries.size() );
+	impl->entries.append( e );
+    }
+    return true;
+}
+
+QPixmapTable * QPixmapTable::current()
+{
+    return Impl::current;
+}
+
+QPixmapTable::Scope::Scope( QPixmapTable & t )
+    : prev(Impl::current)
+{
+    Impl::current = &t;
+}
+QPixmapTable::Scope::Scope()
+    : prev(Impl::current)
+{
+    Impl::current = 0;
+}
+QPixmapTable::Scope::~Scope()
+{
+    Impl::current = prev;
+}
+
 
 bool QPointF_s11n::operator()( S11nNode & dest, QPointF const & src ) const
 {
@@ -856,7 +1083,7 @@ bool QString_s11n::operator()( S11nNode const & src, QString & dest ) const
 		dest = QString( cp ? cp : "" );
 		return true;
 	}
-	else if( NT::is_set( src, "bin64" ) )
+	else if( NT::is_set( src, "bin64" ) || NT::blobs( src ).count( "data" ) )
 	{ // allow QByteArray data
 	    QByteArray tmp;
 	    if( ! s11n::deserialize( src, tmp ) ) return false;
@@ -1,6 +1,9 @@
 #include <qboard/S11nQt.h>
 #include <qboard/S11nQt/Stream.h>
+#include <QFile>
+#include <cstring>
 #include <stdexcept>
+#include <s11n.net/zfstream/zfstream.hpp>
 
 /*
  * This file is (or was, at some point) part of the QBoard project
@@ -19,41 +22,61 @@ namespace s11n { namespace qt {
 
     struct StdToQtOBuf::Impl
     {
-	// FIXME? add a buffer?
 	std::ostream & in;
 	QIODevice & out;
 	std::streambuf * oldBuf;
-	Impl(std::ostream & i, QIODevice & o ) :
+	QByteArray bufa;
+	Impl(std::ostream & i, QIODevice & o, int bufsize ) :
 	    in(i),
 	    out(o),
-	    oldBuf(i.rdbuf())
+	    oldBuf(i.rdbuf()),
+	    bufa()
 	{
 	    if( ! o.isOpen() )
 	    {
 		o.open(QIODevice::WriteOnly);
 	    }
-	    if( o.openMode() != QIODevice::WriteOnly )
+	    if( ! (o.openMode() & QIODevice::WriteOnly) )
 	    {
 		throw std::runtime_error("StdToQtOBuf::StdToQtOBuf() requires that the QIODevice be open (or openable) in WriteOnly mode.");
 	    }
+	    if( bufsize > 0 ) bufa.resize( bufsize );
 	}
 	~Impl()
 	{
 	}
+	/**
+	   Writes all n bytes from src to the device, looping
+	   over short writes. Returns false on a write error.
+	*/
+	bool write( char const * src, qint64 n )
+	{
+	    while( n > 0 )
+	    {
+		const qint64 wr = out.write( src, n );
+		if( wr < 1 ) return false;
+		src += wr;
+		n -= wr;
+	    }
+	    return true;
+	}
     };
 
 
     StdToQtOBuf::StdToQtOBuf( std::ostream & in,
-			      QIODevice & out )
-	: impl(new Impl(in,out))
+			      QIODevice & out,
+			      int bufferSize )
+	: impl(new Impl(in,out,bufferSize))
     {
-	this->setp(0,0);
+	char * b = impl->bufa.isEmpty() ? 0 : impl->bufa.data();
+	this->setp(b, b ? (b + impl->bufa.size()) : 0);
 	this->setg(0,0,0);
 	in.rdbuf( this );
     }
 
     StdToQtOBuf::~StdToQtOBuf()
     {
+	this->sync();
 	std::streambuf * rb = impl->in.rdbuf();
 	if( rb == this )
 	{
@@ -62,17 +85,56 @@ namespace s11n { namespace qt {
 	delete impl;
     }
 
+    bool StdToQtOBuf::flushPutArea()
+    {
+	char * b = this->pbase();
+	const qint64 n = this->pptr() - b;
+	if( ! n ) return true;
+	this->setp( b, this->epptr() );
+	return impl->write( b, n );
+    }
 
     int StdToQtOBuf::overflow(int c)
     {
 	typedef traits_type CT;
-	if (!CT::eq_int_type(c, CT::eof()))
+	if( ! this->flushPutArea() ) return CT::eof();
+	if( CT::eq_int_type(c, CT::eof()) ) return CT::not_eof(c);
+	if( this->pbase() )
 	{
-	    return impl->out.putChar(c)
-		? CT::not_eof(c)
-		: CT::eof();
+	    *this->pptr() = CT::to_char_type(c);
+	    this->pbump(1);
+	    return c;
 	}
-	return CT::eof();
+	return impl->out.putChar( CT::to_char_type(c) )
+	    ? c
+	    : CT::eof();
+    }
+
+    std::streamsize StdToQtOBuf::xsputn( char_type const * src, std::streamsize n )
+    {
+	if( n <= (this->epptr() - this->pptr()) )
+	{
+	    std::memcpy( this->pptr(), src, n );
+	    this->pbump( int(n) );
+	    return n;
+	}
+	if( ! this->flushPutArea() ) return 0;
+	if( n < (this->epptr() - this->pbase()) )
+	{
+	    std::memcpy( this->pptr(), src, n );
+	    this->pbump( int(n) );
+	    return n;
+	}
+	// Bigger than the whole buffer: there's no point in
+	// copying it through the buffer in pieces.
+	return impl->write( src, n ) ? n : 0;
+    }
+
+    int StdToQtOBuf::sync()
+    {
+	if( ! this->flushPutArea() ) return -1;
+	QFile * f = qobject_cast<QFile*>( &impl->out );
+	return (f && ! f->flush()) ? -1 : 0;
     }
 
 
@@ -82,18 +144,17 @@ namespace s11n { namespace qt {
 	QIODevice & qstr;
 	std::streambuf * oldBuf;
 	QByteArray bufa;
-	static const int bufsize = 1024 * 8;
-	Impl(std::istream & i, QIODevice & o ) :
+	Impl(std::istream & i, QIODevice & o, int bufsize ) :
 	    sstr(i),
 	    qstr(o),
 	    oldBuf(i.rdbuf()),
-	    bufa(bufsize,0)
+	    bufa( (bufsize > 0) ? bufsize : 1, 0 )
 	{
 	    if( ! o.isOpen() )
 	    {
 		o.open(QIODevice::ReadOnly);
 	    }
-	    if( o.openMode() != QIODevice::ReadOnly )
+	    if( ! (o.openMode() & QIODevice::ReadOnly) )
 	    {
 		throw std::runtime_error("StdToQtIBuf::StdToQtIBuf() requires that the QIODevice be open (or openable) in ReadOnly mode.");
 	    }
@@ -105,8 +166,9 @@ namespace s11n { namespace qt {
 
 
     StdToQtIBuf::StdToQtIBuf( std::istream & in,
-			      QIODevice & out )
-	: impl(new Impl(in,out))
+			      QIODevice & out,
+			      int bufferSize )
+	: impl(new Impl(in,out,bufferSize))
     {
 	this->setp(0,0);
 	this->setg(0,0,0);
@@ -123,34 +185,98 @@ namespace s11n { namespace qt {
 	delete impl;
     }
 
-    int StdToQtIBuf::underflow()
+    StdToQtIBuf::int_type StdToQtIBuf::underflow()
     {
+	if( this->gptr() < this->egptr() )
+	{
+	    return traits_type::to_int_type(*this->gptr());
+	}
 	char * dest = impl->bufa.data();
-	qint64 rd = impl->qstr.read( dest, Impl::bufsize );
+	qint64 rd = impl->qstr.read( dest, impl->bufa.size() );
 	if( rd < 1 )
 	{
+	    this->setg(dest,dest,dest);
 	    return traits_type::eof();
 	}
 	this->setg(dest,dest,dest+rd);
-	return traits_type::not_eof(*dest);
+	return traits_type::to_int_type(*dest);
     }
 
+    std::streamsize StdToQtIBuf::xsgetn( char_type * dest, std::streamsize n )
+    {
+	std::streamsize got = 0;
+	const std::streamsize bufsize = impl->bufa.size();
+	while( got < n )
+	{
+	    std::streamsize avail = this->egptr() - this->gptr();
+	    if( avail > 0 )
+	    {
+		if( avail > (n - got) ) avail = n - got;
+		std::memcpy( dest + got, this->gptr(), avail );
+		this->gbump( int(avail) );
+		got += avail;
+		continue;
+	    }
+	    if( (n - got) >= bufsize )
+	    {
+		// Read big requests straight into the caller's
+		// memory instead of going through our buffer.
+		const qint64 rd = impl->qstr.read( dest + got, n - got );
+		if( rd < 1 ) break;
+		got += rd;
+		continue;
+	    }
+	    if( traits_type::eq_int_type( this->underflow(), traits_type::eof() ) ) break;
+	}
+	return got;
+    }
 
 
-    QtStdOStream::QtStdOStream( QIODevice & proxy )
-	: m_buf( *this, proxy )
+
+    QtStdOStream::QtStdOStream( QIODevice & proxy, int bufferSize )
+	: m_buf( *this, proxy, bufferSize )
     {
     }
     QtStdOStream::~QtStdOStream()
     {
     }
 
-    QtStdIStream::QtStdIStream( QIODevice & proxy )
-	: m_buf( *this, proxy )
+    QtStdIStream::QtStdIStream( QIODevice & proxy, int bufferSize )
+	: m_buf( *this, proxy, bufferSize )
     {
     }
     QtStdIStream::~QtStdIStream()
     {
     }
 
+    s11nlite::serializer_interface * serializerFor( QString const & fn )
+    {
+	QFile f( fn );
+	if( ! f.open( QIODevice::ReadOnly ) ) return 0;
+	QtStdIStream is( f );
+	std::auto_ptr<std::istream> zis( zfstream::get_istream( is ) );
+	return s11n::io::guess_serializer<S11nNode>( zis.get() ? *zis : is );
+    }
+
+    S11nNode * loadNode( QString const & fn, s11nlite::serializer_interface * ser )
+    {
+	std::auto_ptr<s11nlite::serializer_interface> own;
+	if( ! ser )
+	{
+	    own.reset( serializerFor( fn ) );
+	    ser = own.get();
+	    if( ! ser ) return 0;
+	}
+	QFile f( fn );
+	if( ! f.open( QIODevice::ReadOnly | QIODevice::Unbuffered ) ) return 0;
+	QtStdIStream is( f );
+	// Decompresses the file if needed.
+	std::auto_ptr<std::istream> zis( zfstream::get_istream( is ) );
+	std::istream & in( zis.get() ? *zis : is );
+	// Like s11nlite::load_node(istream), but with the given
+	// serializer: skip the cookie, then parse the rest.
+	s11n::io::get_magic_cookie( in );
+	return ser->deserialize( in );
+    }
+
 }} // namespace
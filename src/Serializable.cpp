@@ -18,6 +18,10 @@
 #include <s11n.net/s11n/s11nlite.hpp>
 #include <s11n.net/s11n/functional.hpp>
 #include <QRegExp>
+#include <QFile>
+#include <qboard/S11nQt/Stream.h>
+#include <qboard/S11nQt/QPixmap.h>
+#include <s11n.net/zfstream/zfstream.hpp>
 
 struct Serializable::Impl
 {
@@ -64,6 +68,7 @@ Serializable::Serializable( Serializable const & )
 
 Serializable * Serializable::clone() const
 {
+    s11n::qt::QPixmapTable::Scope inlinePixmaps;
     S11nNode node;
     return this->serialize( node )
 	? s11nlite::deserialize<Serializable>( node )
@@ -74,6 +79,7 @@ Serializable & Serializable::copy( Serializable const & rhs )
 {
     if( &rhs != this )
     {
+	s11n::qt::QPixmapTable::Scope inlinePixmaps;
 	S11nNode node;
 	if( ! rhs.serialize( node ) )
 	{
@@ -139,7 +145,7 @@ bool Serializable::s11nLoad( std::istream & is )
 	: false;
 }
 
-bool Serializable::s11nSave( QString const & src, bool autoAddFileExtension ) const
+QString Serializable::s11nSaveName( QString const & src, bool autoAddFileExtension ) const
 {
     QString rn( src );
     if( autoAddFileExtension && ! impl->ext.empty() )
@@ -151,14 +157,30 @@ bool Serializable::s11nSave( QString const & src, bool autoAddFileExtension ) co
 	    rn = src + impl->ext.c_str();
 	}
     }
-    return s11nlite::save<Serializable>( *this, rn.toAscii().constData() );
+    return rn;
+}
+
+bool Serializable::s11nSave( QString const & src, bool autoAddFileExtension ) const
+{
+    QString rn( this->s11nSaveName( src, autoAddFileExtension ) );
+    // Go through QFile so that we get unicode file names.
+    // StdToQtOBuf does the buffering, so QFile doesn't need to.
+    QFile f( rn );
+    if( ! f.open( QIODevice::WriteOnly | QIODevice::Unbuffered ) ) return false;
+    s11n::qt::QtStdOStream os( f );
+    bool ok = false;
+    {
+	std::auto_ptr<std::ostream> zos( zfstream::get_ostream( os ) );
+	ok = s11nlite::save<Serializable>( *this, zos.get() ? *zos : os );
+    }
+    return ok && os.flush().good();
 }
 
 bool Serializable::s11nLoad( QString const & fn)
 {
     if( fn.isEmpty() ) return false;
     typedef std::auto_ptr<S11nNode> NP;
-    NP np( s11nlite::load_node( fn.toAscii().constData() ) );
+    NP np( s11n::qt::loadNode( fn ) );
     return np.get()
 	? this->deserialize( *np )
 	: false;
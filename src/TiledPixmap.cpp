@@ -0,0 +1,185 @@
+/*
+ * This file is (or was, at some point) part of the QBoard project
+ * (http://code.google.com/p/qboard)
+ *
+ * Copyright (c) 2008 Stephan Beal (http://wanderinghorse.net/home/stephan/)
+ *
+ * This file may be used under the terms of the GNU General Public
+ * License versions 2.0 or 3.0 as published by the Free Software
+ * Foundation and appearing in the files LICENSE.GPL2 and LICENSE.GPL3
+ * included in the packaging of this file.
+ *
+ */
+
+#include <QDebug>
+#include <QPainter>
+#include <QVector>
+
+#include <cmath>
+
+#include <qboard/TiledPixmap.h>
+
+namespace qboard
+{
+    struct TiledPixmap::Impl
+    {
+	/** The source pixmap. Not owned by this object. */
+	QPixmap const * src;
+	/**
+	   levels[N] is levels[N-1] scaled to half its size, where
+	   level 0 is *src. levels[0] itself is never used, since
+	   copying *src into it would make src's data shared, and
+	   painting into src would then deep-copy it. Null entries
+	   have not been built yet.
+	*/
+	QVector<QPixmap> levels;
+	Impl() : src(0), levels()
+	{
+	}
+	~Impl()
+	{
+	}
+
+	/**
+	   Returns the highest mip level worth building for the current
+	   pixmap: we stop once a level fits into a single tile.
+	*/
+	int maxLevel() const
+	{
+	    if( ! src ) return 0;
+	    QSize sz( src->size() );
+	    int lv = 0;
+	    while( (sz.width() > TileSize) || (sz.height() > TileSize) )
+	    {
+		sz = QSize( (sz.width()+1)/2, (sz.height()+1)/2 );
+		++lv;
+	    }
+	    return lv;
+	}
+
+	/**
+	   Returns the given mip level, building it (and any levels
+	   between it and the closest built level) if needed.
+	*/
+	QPixmap const & level( int lv )
+	{
+	    if( 0 == lv ) return *src;
+	    if( lv >= levels.size() ) levels.resize( lv + 1 );
+	    if( levels[lv].isNull() )
+	    {
+		QPixmap const & up( this->level( lv - 1 ) );
+		levels[lv] = up.scaled( (up.width()+1)/2, (up.height()+1)/2,
+					Qt::IgnoreAspectRatio,
+					Qt::SmoothTransformation );
+	    }
+	    return levels[lv];
+	}
+    };
+
+    TiledPixmap::TiledPixmap() : impl(new Impl)
+    {
+    }
+
+    TiledPixmap::~TiledPixmap()
+    {
+	delete impl;
+    }
+
+    void TiledPixmap::setPixmap( QPixmap const * pix )
+    {
+	impl->levels.clear();
+	impl->src = pix;
+    }
+
+    QPixmap const & TiledPixmap::pixmap() const
+    {
+	static const QPixmap bogus;
+	return impl->src ? *impl->src : bogus;
+    }
+
+    void TiledPixmap::invalidate( QRect const & r )
+    {
+	if( r.isNull() || ! impl->src )
+	{
+	    impl->levels.clear();
+	    return;
+	}
+	/**
+	   Re-scale only the changed area of each level which has
+	   already been built, from the level above it. Progressive
+	   loads call this once per chunk, and dropping (and later
+	   rebuilding) every level each time would make them
+	   quadratic.
+
+	   The dirty rect is grown by one pixel per level to cover the
+	   reach of the smoothing filter.
+	*/
+	QRect dirty( r.intersected( impl->src->rect() ) );
+	for( int lv = 1; (lv < impl->levels.size()) && ! dirty.isEmpty(); ++lv )
+	{
+	    QPixmap & cur( impl->levels[lv] );
+	    if( cur.isNull() )
+	    { // higher levels are built from this one, so they're stale, too.
+		impl->levels.resize( lv );
+		break;
+	    }
+	    QPixmap const & up( impl->level( lv - 1 ) );
+	    const QRect d( QRect( QPoint( dirty.left() / 2, dirty.top() / 2 ),
+				  QPoint( dirty.right() / 2, dirty.bottom() / 2 ) )
+			   .adjusted( -1, -1, 1, 1 ).intersected( cur.rect() ) );
+	    const QRect s( QRect( d.topLeft() * 2, d.size() * 2 ).intersected( up.rect() ) );
+	    if( d.isEmpty() || s.isEmpty() ) break;
+	    const QPixmap part( up.copy( s ).scaled( d.size(),
+						     Qt::IgnoreAspectRatio,
+						     Qt::SmoothTransformation ) );
+	    QPainter p( &cur );
+	    p.setCompositionMode( QPainter::CompositionMode_Source );
+	    p.drawPixmap( d.topLeft(), part );
+	    dirty = d;
+	}
+    }
+
+    void TiledPixmap::draw( QPainter * p, QRectF const & exposed )
+    {
+	if( ! impl->src || impl->src->isNull() ) return;
+	QPixmap const & orig( *impl->src );
+	const QRectF want( exposed.intersected( QRectF( QPointF(0,0), orig.size() ) ) );
+	if( want.isEmpty() ) return;
+
+	// Pick the smallest level which still has at least one pixel
+	// per device pixel. QTransform::determinant() is Qt 4.6+, so
+	// we do it by hand:
+	const QTransform t( p->worldTransform() );
+	qreal sc = std::sqrt( std::fabs( t.m11() * t.m22() - t.m12() * t.m21() ) );
+	const int maxlv = impl->maxLevel();
+	int lv = 0;
+	while( (lv < maxlv) && (sc <= 0.5) )
+	{
+	    sc *= 2;
+	    ++lv;
+	}
+	QPixmap const & lp( impl->level( lv ) );
+	// Ratio of pixmap coordinates to level coordinates. Not
+	// exactly 2^lv because of the rounding when halving.
+	const qreal fx = qreal(orig.width()) / lp.width();
+	const qreal fy = qreal(orig.height()) / lp.height();
+
+	const int tx0 = int( want.left() / fx ) / TileSize;
+	const int ty0 = int( want.top() / fy ) / TileSize;
+	const int tx1 = int( std::ceil( want.right() / fx ) - 1 ) / TileSize;
+	const int ty1 = int( std::ceil( want.bottom() / fy ) - 1 ) / TileSize;
+	const QRect lrect( lp.rect() );
+	for( int ty = ty0; ty <= ty1; ++ty )
+	{
+	    for( int tx = tx0; tx <= tx1; ++tx )
+	    {
+		const QRect src( QRect( tx * TileSize, ty * TileSize, TileSize, TileSize ).intersected( lrect ) );
+		if( src.isEmpty() ) continue;
+		const QRectF dest( src.x() * fx, src.y() * fy,
+				   src.width() * fx, src.height() * fy );
+		p->drawPixmap( dest, lp, QRectF(src) );
+	    }
+	}
+    }
+
+} // namespace
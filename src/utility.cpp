@@ -29,6 +29,7 @@
 #include <qboard/S11nQt.h>
 #include <qboard/S11nQt/QList.h>
 #include <qboard/GameState.h>
+#include <qboard/QBoardScene.h>
 
 #include <qboard/S11nQt/QPointF.h>
 #include <qboard/S11nQt/QPoint.h>
@@ -178,6 +179,7 @@ namespace qboard {
 	    if( sc )
 	    {
 		if(0) qDebug() << "qboard::destroyToplevelItems(QList) asking Scene to remove *it:"<<*it;
+		QBoardScene::invalidateZOrder( *it );
 		sc->removeItem(*it);
 	    }
 #if 1 // i don't like this, but it avoids some crashes!
@@ -365,6 +367,7 @@ namespace qboard {
 	S11nNode * parent = S11nNodeTraits::create(GameState::KeyClipboard);
 	try
 	{
+	    s11n::qt::QPixmapTable::Scope inlinePixmaps;
 	    bool ret = true;
 	    S11nNode & meta( s11n::create_child( *parent, "metadata") );
 	    if( 1 ) //! origin.isNull() )